@@ -25,6 +25,7 @@
 #endif
 
 #include <exception>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -38,6 +39,7 @@ namespace ancient
 
 namespace internal
 {
+class MappedFile;
 namespace APIv2
 {
 class DecompressorImpl;
@@ -76,6 +78,13 @@ public:
 	~VerificationError() noexcept;
 };
 
+class ANCIENT_API IOError : public Error
+{
+public:
+	IOError() noexcept;
+	~IOError() noexcept;
+};
+
 class ANCIENT_API Decompressor final
 {
 
@@ -94,6 +103,11 @@ public:
 	explicit Decompressor(const std::vector<uint8_t> &packedData,bool exactSizeKnown,bool verify);
 	explicit Decompressor(const uint8_t *packedData,size_t packedSize,bool exactSizeKnown,bool verify);
 
+	// Same as above, but the packed data is read from a file. The file is memory mapped when possible
+	// so that only the parts needed are read in, and the data is not copied
+	// can throw IOError if the file can not be read
+	explicit Decompressor(const std::string &fileName,bool exactSizeKnown,bool verify);
+
 	// Name returned is human readable long name
 	const std::string &getName() const noexcept;
 
@@ -105,6 +119,11 @@ public:
 	static size_t getMaxPackedSize() noexcept;
 	static size_t getMaxRawSize() noexcept;
 
+	// Some formats are decompressed using multiple threads. The threads are shared between
+	// all the decompressors. maxThreads limits the number of threads working at the same time
+	// for a single decompress, including the calling thread. 0 for the number of cores (default)
+	static void setMaxThreads(uint32_t maxThreads) noexcept;
+
 	// PackedSize or RawSize are taken from the stream if available, std::nullopt otherwise.
 	// for those compressors having no known sizes, running decompression will update
 	// the values.
@@ -122,12 +141,44 @@ public:
 	std::optional<size_t> getImageSize() const noexcept;
 	std::optional<size_t> getImageOffset() const noexcept;
 
+	// For formats where the raw size is not known before decompressing (getRawSize returns std::nullopt)
+	// the output is grown while decompressing. If the caller has an idea of the size
+	// (f.e. from an archive directory) it can be given here, so the output is allocated once.
+	// The hint does not need to be exact
+	void setRawSizeHint(size_t rawSizeHint) noexcept;
+
+	// Obsfuscated PowerPacker files need a search for the key before decompressing.
+	// Usually it takes a fraction of a second, but broken files can take much longer.
+	// The search is stopped, and decompression fails with DecompressionError, when it runs
+	// more than maxIterations steps (0 for no limit) or when progress returns false.
+	// maxIterations is split evenly between the search tasks.
+	// progress is called with the number of finished and total search tasks. It can be called
+	// from any thread, but never concurrently
+	void setKeySearchBudget(size_t maxIterations) noexcept;
+	void setKeySearchProgress(const std::function<bool(size_t done,size_t total)> &progress);
+
 	// Actual decompression.
 	// verify checksum if verify==true
 	// can throw DecompressionError if stream cant be unpacked
 	// can throw VerificationError if verify enabled and checksum does not match
 	std::vector<uint8_t> decompress(bool verify);
 
+	// Decompression into a caller provided buffer. Returns the size of the raw data written.
+	// can throw DecompressionError if the raw data does not fit into the buffer
+	size_t decompress(uint8_t *rawData,size_t rawDataSize,bool verify);
+
+	// Decompression into an existing vector, which is resized to the size of the raw data.
+	// Allocated capacity is kept, so the same vector can be re-used for multiple files
+	void decompress(std::vector<uint8_t> &rawData,bool verify);
+
+	// Streaming decompression.
+	// sink is called with consecutive pieces of the raw data as they are produced.
+	// Formats with bounded history (gzip/zlib, bzip2, Compress, Freeze and XPK chunk-by-chunk)
+	// keep only the history in memory. Other formats are decompressed fully and
+	// given to the sink in one piece.
+	// can throw the same errors as decompress above. Exceptions from the sink are passed through
+	void decompress(bool verify,const std::function<void(const uint8_t *data,size_t size)> &sink);
+
 	~Decompressor() noexcept;
 
 private:
@@ -141,6 +192,56 @@ private:
 
 };
 
+// Read-only memory mapped file. Useful for keeping large inputs out of the heap
+// f.e. when scanning. Falls back to reading the file when mapping is not possible
+class ANCIENT_API MappedFile final
+{
+public:
+	// can throw IOError if the file can not be read
+	explicit MappedFile(const std::string &fileName);
+	~MappedFile() noexcept;
+
+	const uint8_t *data() const noexcept;
+	size_t size() const noexcept;
+
+private:
+
+	std::unique_ptr<internal::MappedFile> m_impl;
+
+private:
+
+	MappedFile(const MappedFile&)=delete;
+	MappedFile& operator=(const MappedFile&)=delete;
+
+};
+
+// Carving of compressed streams from larger data (f.e. disk dumps)
+class ANCIENT_API Scanner final
+{
+public:
+
+	struct Hit
+	{
+		size_t		offset;
+		size_t		packedSize;
+		size_t		rawSize;
+		std::string	name;
+	};
+
+	// Scans data for compressed streams. Offsets are first filtered by the signatures of
+	// all the known formats and then the candidates are verified by decompressing them.
+	// Found streams are reported in the order of their offset and they do not overlap.
+	// Formats without a proper signature (f.e. ByteKiller or StoneCracker before 3.00) are not searched for.
+	// Exceptions from func are passed through
+	static void scan(const uint8_t *data,size_t size,const std::function<void(const Hit &hit)> &func);
+	static std::vector<Hit> scan(const uint8_t *data,size_t size);
+
+private:
+
+	Scanner()=delete;
+
+};
+
 }
 
 }
@@ -1,15 +1,19 @@
 /* Copyright (C) Teemu Suutari */
 
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <new>
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <optional>
 
@@ -60,8 +64,9 @@ static bool writeFile(const std::string &fileName,const uint8_t *data, size_t si
 	if (file.is_open())
 	{
 		file.write(reinterpret_cast<const char*>(data),size);
-		ret=bool(file);
+		// buffered data is written on close, which can fail as well (f.e. disk full)
 		file.close();
+		ret=bool(file);
 	}
 	if (!ret)
 	{
@@ -87,6 +92,102 @@ static bool writeFile(const std::string &fileName,const std::vector<uint8_t> &co
 	return writeFile(fileName,content.data(),content.size());
 }
 
+// decompresses packed file to output file, or verifies the decompressed data against it when verifyOnly is set
+static bool decompressFile(const std::string &packedName,const std::string &outputName,bool verifyOnly,bool preserveTimestamps)
+{
+	std::optional<ancient::Decompressor> decompressor;
+	try
+	{
+		decompressor.emplace(packedName,true,true);
+	} catch (const ancient::IOError&)
+	{
+		fprintf(stderr,"Could not read file %s\n",packedName.c_str());
+		return false;
+	} catch (const ancient::InvalidFormatError&)
+	{
+		fprintf(stderr,"Unknown or invalid compression format in file %s\n",packedName.c_str());
+		return false;
+	} catch (const ancient::VerificationError&)
+	{
+		fprintf(stderr,"Verify (packed) failed for %s\n",packedName.c_str());
+		return false;
+	}
+
+	std::vector<uint8_t> raw;
+	try
+	{
+		raw=decompressor->decompress(true);
+	} catch (const ancient::DecompressionError&)
+	{
+		fprintf(stderr,"Decompression failed for %s\n",packedName.c_str());
+		return false;
+	} catch (const ancient::VerificationError&)
+	{
+		fprintf(stderr,"Verify (raw) failed for %s\n",packedName.c_str());
+		return false;
+	} catch (const std::bad_alloc&) {
+		fprintf(stderr,"Out of memory\n");
+		return false;
+	}
+
+	if (!verifyOnly)
+	{
+		if (decompressor->getImageOffset() || decompressor->getImageSize())
+		{
+			printf("File %s is disk image, decompressed stream offset is %zu, full image size is %zu, stream size is %zu\n",packedName.c_str(),decompressor->getImageOffset().value(),decompressor->getImageSize().value(),decompressor->getRawSize().value());
+			printf("!!! Please note !!!\n!!! The destination will be padded !!!\n\n");
+		}
+		if (decompressor->getImageSize())
+		{
+			std::vector<uint8_t> pad(decompressor->getImageSize().value());
+			std::memcpy(&pad[decompressor->getImageOffset()?decompressor->getImageOffset().value():0],raw.data(),raw.size());
+			if (!writeFile(outputName,pad)) return false;
+		} else {
+			if (!writeFile(outputName,raw)) return false;
+		}
+		if (preserveTimestamps) copyMTime(outputName,packedName);
+		return true;
+	} else {
+		size_t actualSize=decompressor->getImageSize()?decompressor->getImageSize().value():raw.size();
+		auto verify{readFile(outputName)};
+		if (!verify) return false;
+		if (verify->size()!=actualSize)
+		{
+			fprintf(stderr,"Verify failed for %s and %s - sizes differ\n",packedName.c_str(),outputName.c_str());
+			return false;
+		}
+		size_t offset=decompressor->getImageOffset()?decompressor->getImageOffset().value():0;
+		for (size_t i=0;i<raw.size();i++)
+		{
+			if (raw.data()[i]!=verify->data()[i+offset])
+			{
+				fprintf(stderr,"Verify failed for %s and %s - contents differ @ %zu\n",packedName.c_str(),outputName.c_str(),i);
+				return false;
+			}
+		}
+		printf("Files match!\n");
+		return true;
+	}
+}
+
+// Runs func for each item using the given number of threads. Each thread picks the next
+// unprocessed item once it is done with the previous one. func should not throw
+static void forEachParallel(size_t items,uint32_t threads,const std::function<void(size_t)> &func)
+{
+	std::atomic<size_t> next{0};
+	auto worker=[&]()
+	{
+		for (size_t i;(i=next++)<items;)
+			func(i);
+	};
+	std::vector<std::thread> pool;
+	for (uint32_t i=1;i<threads && i<items;i++)
+		pool.emplace_back(worker);
+	worker();
+	for (auto &it : pool)
+		it.join();
+}
+
 int main(int argc,char **argv)
 {
 	auto usage=[]()
@@ -100,9 +201,13 @@ int main(int argc,char **argv)
 				" - verifies decompression against known good unpacked file\n"
 				"Usage: ancient [-p] d[ecompress] packed_input_file output_file\n"
 				" - decompresses single file\n"
-				" - use p-flag to preserve timestamp of the original\n");
+				" - use p-flag to preserve timestamp of the original\n"
+				"Usage: ancient [-p] [-j jobs] b[atch] output_dir packed_input_files...\n"
+				" - decompresses multiple files into output directory concurrently\n"
+				" - use j-flag to set the number of parallel jobs\n"
+				" - the number of jobs also limits the threads used for a single file\n");
 #ifdef ENABLE_SCAN
-		fprintf(stderr,	"Usage: ancient s[can] input_dir output_dir\n"
+		fprintf(stderr,	"Usage: ancient [-j jobs] s[can] input_dir output_dir\n"
 				" - scans input directory recursively and stores all found\n"
 				" - known compressed streams to separate files in output directory\n");
 #endif
@@ -110,21 +215,35 @@ int main(int argc,char **argv)
 
 
 	bool preserveTimestamps=false;
+	uint32_t jobs=std::thread::hardware_concurrency();
+	if (!jobs) jobs=1;
 	// getopt requires extra deps on windows. Do something very simple (and little bit ugly)
-	if (argc>=2 && argv[1][0]=='-')
+	while (argc>=2 && argv[1][0]=='-')
 	{
 		std::string opts=argv[1];
+		int consumed=1;
 		if (opts=="-p") preserveTimestamps=true;
-		else
+		else if (opts=="-j" && argc>=3)
 		{
+			jobs=uint32_t(std::strtoul(argv[2],nullptr,10));
+			if (!jobs)
+			{
+				usage();
+				return -1;
+			}
+			consumed=2;
+		} else {
 			usage();
 			return -1;
 		}
-		--argc;
+		argc-=consumed;
 		for (int i=1;i<argc;i++)
-			argv[i]=argv[i+1];
+			argv[i]=argv[i+consumed];
 	}
 
+	// also limits the threads used inside the decompressors
+	ancient::Decompressor::setMaxThreads(jobs);
+
 	if (argc<3)
 	{
 		usage();
@@ -141,13 +260,15 @@ int main(int argc,char **argv)
 		}
 		for (int i=2;i<argc;i++)
 		{
-			auto packed{readFile(argv[i])};
-			if (!packed) return -1;
 			std::optional<ancient::Decompressor> decompressor;
 			try
 			{
-				decompressor.emplace(*packed,true,true);
+				decompressor.emplace(std::string(argv[i]),true,true);
 				printf("Compression of %s is %s\n",argv[i],decompressor->getName().c_str());
+			} catch (const ancient::IOError&)
+			{
+				fprintf(stderr,"Could not read file %s\n",argv[i]);
+				return -1;
 			} catch (const ancient::InvalidFormatError&)
 			{
 				fprintf(stderr,"Unknown or invalid compression format in file %s\n",argv[i]);
@@ -163,77 +284,36 @@ int main(int argc,char **argv)
 			usage();
 			return -1;
 		}
-		auto packed{readFile(argv[2])};
-		if (!packed) return -1;
-		std::optional<ancient::Decompressor> decompressor;
-		try
-		{
-			decompressor.emplace(*packed,true,true);
-		} catch (const ancient::InvalidFormatError&)
-		{
-			fprintf(stderr,"Unknown or invalid compression format in file %s\n",argv[2]);
-			return -1;
-		} catch (const ancient::VerificationError&)
-		{
-			fprintf(stderr,"Verify (packed) failed for %s\n",argv[2]);
-			return -1;
-		}
-
-		std::vector<uint8_t> raw;
-		try
-		{
-			raw=decompressor->decompress(true);
-		} catch (const ancient::DecompressionError&)
-		{
-			fprintf(stderr,"Decompression failed for %s\n",argv[2]);
-			return -1;
-		} catch (const ancient::VerificationError&)
+		return decompressFile(argv[2],argv[3],cmd=="v" || cmd=="verify",preserveTimestamps)?0:-1;
+	} else if (cmd=="b" || cmd=="batch") {
+		if (argc<4)
 		{
-			fprintf(stderr,"Verify (raw) failed for %s\n",argv[2]);
-			return -1;
-		} catch (const std::bad_alloc&) {
-			fprintf(stderr,"Out of memory\n");
+			usage();
 			return -1;
 		}
-
-		if (cmd=="d" || cmd=="decompress")
+		// output names are resolved up front so that workers never write the same file
+		std::string outputDir=argv[2];
+		std::vector<std::string> outputNames;
+		std::set<std::string> usedNames;
+		for (int i=3;i<argc;i++)
 		{
-			if (decompressor->getImageOffset() || decompressor->getImageSize())
-			{
-				printf("File %s is disk image, decompressed stream offset is %zu, full image size is %zu, stream size is %zu\n",argv[2],decompressor->getImageOffset().value(),decompressor->getImageSize().value(),decompressor->getRawSize().value());
-				printf("!!! Please note !!!\n!!! The destination will be padded !!!\n\n");
-			}
-			if (decompressor->getImageSize())
-			{
-				std::vector<uint8_t> pad(decompressor->getImageSize().value());
-				std::memcpy(&pad[decompressor->getImageOffset()?decompressor->getImageOffset().value():0],raw.data(),raw.size());
-				writeFile(argv[3],pad);
-			} else {
-				writeFile(argv[3],raw);
-			}
-			if (preserveTimestamps) copyMTime(argv[3],argv[2]);
-			return 0;
-		} else {
-			size_t actualSize=decompressor->getImageSize()?decompressor->getImageSize().value():raw.size();
-			auto verify{readFile(argv[3])};
-			if (!verify) return -1;
-			if (verify->size()!=actualSize)
+			std::string name=argv[i];
+			size_t pos=name.find_last_of("/\\");
+			std::string baseName=(pos==std::string::npos)?name:name.substr(pos+1);
+			if (!usedNames.insert(baseName).second)
 			{
-				fprintf(stderr,"Verify failed for %s and %s - sizes differ\n",argv[2],argv[3]);
+				fprintf(stderr,"Duplicate output name %s for file %s\n",baseName.c_str(),argv[i]);
 				return -1;
 			}
-			size_t offset=decompressor->getImageOffset()?decompressor->getImageOffset().value():0;
-			for (size_t i=0;i<raw.size();i++)
-			{
-				if (raw.data()[i]!=verify->data()[i+offset])
-				{
-					fprintf(stderr,"Verify failed for %s and %s - contents differ @ %zu\n",argv[2],argv[3],i);
-					return -1;
-				}
-			}
-			printf("Files match!\n");
-			return 0;
+			outputNames.push_back(outputDir+"/"+baseName);
 		}
+		// every worker has only one file in flight
+		std::atomic<bool> success{true};
+		forEachParallel(size_t(argc-3),jobs,[&](size_t i)
+		{
+			if (!decompressFile(argv[i+3],outputNames[i],false,preserveTimestamps)) success=false;
+		});
+		return success?0:-1;
 	}
 #ifdef ENABLE_SCAN
 	else if (cmd=="s" || cmd=="scan") {
@@ -242,7 +322,8 @@ int main(int argc,char **argv)
 			usage();
 			return -1;
 		}
-		uint32_t fileIndex=0;
+		// collect the files first, scanning happens in parallel
+		std::vector<std::string> fileNames;
 		std::function<void(std::string)> processDir=[&](std::string inputDir)
 		{
 			auto opendir=[](const char *f)->DIR* {
@@ -267,52 +348,7 @@ int main(int argc,char **argv)
 					{
 						processDir(name);
 					} else if (st.st_mode&S_IFREG) {
-						auto packed{readFile(name)};
-						if (!packed) return -1;
-						for (size_t i=0;i<packed->size();)
-						{
-							// We will detect first, before trying the format for real
-							if (!ancient::Decompressor::detect(packed->data()+i,packed->size()-i))
-							{
-								i++;
-								continue;
-							}
-							try
-							{
-								ancient::Decompressor decompressor{packed->data()+i,packed->size()-i,false,true};
-
-								printf("trying %s\n",decompressor.getName().c_str());
-								if (!decompressor.getPackedSize())
-								{
-									// for formats that do not encode packed size.
-									// we will get it from decompressor
-									decompressor.decompress(true);
-								}
-
-								// final checks with the limited buffer and fresh decompressor
-								const uint8_t *finalData=packed->data()+i;
-								size_t finalSize=decompressor.getPackedSize().value();
-								ancient::Decompressor decompressor2{finalData,finalSize,true,true};
-								try
-								{
-									decompressor2.decompress(true);
-								} catch (const std::bad_alloc&) {
-									fprintf(stderr,"Out of memory\n");
-									i++;
-									continue;
-								}
-								std::string outputName=std::string(argv[3])+"/file"+std::to_string(fileIndex++)+".pack";
-								printf("Found compressed stream at %zu, size %zu in file %s with type '%s', storing it into %s\n",i,decompressor2.getPackedSize().value(),name.c_str(),decompressor2.getName().c_str(),outputName.c_str());
-								writeFile(outputName,finalData,finalSize);
-								i+=finalSize;
-								continue;
-							} catch (const ancient::Error&) {
-								// full steam ahead (with next offset)
-							} catch (const std::bad_alloc&) {
-								// full steam ahead (with next offset)
-							}
-							i++;
-						}
+						fileNames.push_back(name);
 					}
 				}
 			} else {
@@ -321,7 +357,27 @@ int main(int argc,char **argv)
 		};
 
 		processDir(std::string(argv[2]));
-		return 0;
+		std::atomic<uint32_t> fileIndex{0};
+		std::atomic<bool> success{true};
+		forEachParallel(fileNames.size(),jobs,[&](size_t i)
+		{
+			const std::string &name=fileNames[i];
+			std::optional<ancient::MappedFile> packed;
+			try
+			{
+				packed.emplace(name);
+			} catch (const ancient::IOError&) {
+				fprintf(stderr,"Could not read file %s\n",name.c_str());
+				return;
+			}
+			ancient::Scanner::scan(packed->data(),packed->size(),[&](const ancient::Scanner::Hit &hit)
+			{
+				std::string outputName=std::string(argv[3])+"/file"+std::to_string(fileIndex++)+".pack";
+				printf("Found compressed stream at %zu, size %zu in file %s with type '%s', storing it into %s\n",hit.offset,hit.packedSize,name.c_str(),hit.name.c_str(),outputName.c_str());
+				if (!writeFile(outputName,packed->data()+hit.offset,hit.packedSize)) success=false;
+			});
+		});
+		return success?0:-1;
 	}
 #endif
 	else {
@@ -2,7 +2,10 @@
 
 #include "ancient.hpp"
 #include "Decompressor.hpp"
+#include "Scanner.hpp"
 #include "common/Buffer.hpp"
+#include "common/MappedFile.hpp"
+#include "common/Parallel.hpp"
 #include "common/StaticBuffer.hpp"
 #include "common/WrappedVectorBuffer.hpp"
 
@@ -20,6 +23,7 @@ namespace APIv2
 class DecompressorImpl
 {
 public:
+	std::unique_ptr<MappedFile> _file;
 	ConstStaticBuffer _buffer;
 	std::shared_ptr<Decompressor> _decompressor;
 
@@ -35,6 +39,13 @@ public:
 	{
 		// nothing needed
 	}
+	DecompressorImpl(const std::string &fileName,bool exactSizeKnown,bool verify) :
+		_file{std::make_unique<MappedFile>(fileName)},
+		_buffer{_file->data(), _file->size()},
+		_decompressor{Decompressor::create(_buffer, exactSizeKnown, verify)}
+	{
+		// nothing needed
+	}
 };
 
 }
@@ -84,6 +95,16 @@ VerificationError::~VerificationError() noexcept
 	// nothing needed
 }
 
+IOError::IOError() noexcept
+{
+	// nothing needed
+}
+
+IOError::~IOError() noexcept
+{
+	// nothing needed
+}
+
 // ---
 
 bool Decompressor::detect(const std::vector<uint8_t> &packedData) noexcept
@@ -108,6 +129,12 @@ Decompressor::Decompressor(const uint8_t *packedData,size_t packedSize,bool exac
 	return;
 }
 
+Decompressor::Decompressor(const std::string &fileName,bool exactSizeKnown,bool verify) :
+	m_impl{std::make_unique<internal::APIv2::DecompressorImpl>(fileName, exactSizeKnown, verify)}
+{
+	return;
+}
+
 const std::string &Decompressor::getName() const noexcept
 {
 	return m_impl->_decompressor->getName();
@@ -123,6 +150,11 @@ size_t Decompressor::getMaxRawSize() noexcept
 	return internal::Decompressor::getMaxRawSize();
 }
 
+void Decompressor::setMaxThreads(uint32_t maxThreads) noexcept
+{
+	internal::Parallel::setMaxThreads(maxThreads);
+}
+
 std::optional<size_t> Decompressor::getPackedSize() const noexcept
 {
 	size_t packedSize=m_impl->_decompressor->getPackedSize();
@@ -167,22 +199,104 @@ std::optional<size_t> Decompressor::getImageOffset() const noexcept
 	return imageOffset;
 }
 
+void Decompressor::setRawSizeHint(size_t rawSizeHint) noexcept
+{
+	m_impl->_decompressor->setRawSizeHint(rawSizeHint);
+}
+
+void Decompressor::setKeySearchBudget(size_t maxIterations) noexcept
+{
+	m_impl->_decompressor->setKeySearchBudget(maxIterations);
+}
+
+void Decompressor::setKeySearchProgress(const std::function<bool(size_t done,size_t total)> &progress)
+{
+	m_impl->_decompressor->setKeySearchProgress(progress);
+}
+
 std::vector<uint8_t> Decompressor::decompress(bool verify)
 {
-	std::vector<uint8_t> result((m_impl->_decompressor->getRawSize())?m_impl->_decompressor->getRawSize():0);
-	{
-		internal::WrappedVectorBuffer buffer(result);
-		m_impl->_decompressor->decompress(buffer, verify);
-	}
+	std::vector<uint8_t> result;
+	decompress(result,verify);
 	result.shrink_to_fit();
 	return result;
 }
 
+size_t Decompressor::decompress(uint8_t *rawData,size_t rawDataSize,bool verify)
+{
+	// when size is known give exactly that. Otherwise the whole buffer is available
+	size_t rawSize=m_impl->_decompressor->getRawSize();
+	if (rawSize>rawDataSize)
+		throw DecompressionError();
+	internal::MutableStaticBuffer buffer(rawData,rawSize?rawSize:rawDataSize);
+	m_impl->_decompressor->decompress(buffer, verify);
+	return m_impl->_decompressor->getRawSize();
+}
+
+void Decompressor::decompress(std::vector<uint8_t> &rawData,bool verify)
+{
+	rawData.resize(m_impl->_decompressor->getRawSize());
+	internal::WrappedVectorBuffer buffer(rawData);
+	m_impl->_decompressor->decompress(buffer, verify);
+}
+
+void Decompressor::decompress(bool verify,const std::function<void(const uint8_t *data,size_t size)> &sink)
+{
+	m_impl->_decompressor->decompress([&](const internal::Buffer &data)
+	{
+		sink(data.data(),data.size());
+	},verify);
+}
+
 Decompressor::~Decompressor() noexcept
 {
 	// nothing needed
 }
 
+// ---
+
+MappedFile::MappedFile(const std::string &fileName) :
+	m_impl{std::make_unique<internal::MappedFile>(fileName)}
+{
+	// nothing needed
+}
+
+MappedFile::~MappedFile() noexcept
+{
+	// nothing needed
+}
+
+const uint8_t *MappedFile::data() const noexcept
+{
+	return m_impl->data();
+}
+
+size_t MappedFile::size() const noexcept
+{
+	return m_impl->size();
+}
+
+// ---
+
+void Scanner::scan(const uint8_t *data,size_t size,const std::function<void(const Hit &hit)> &func)
+{
+	internal::ConstStaticBuffer buffer(data,size);
+	internal::Scanner::scan(buffer,[&](size_t offset,const internal::Decompressor &decompressor)
+	{
+		func(Hit{offset,decompressor.getPackedSize(),decompressor.getRawSize(),decompressor.getName()});
+	});
+}
+
+std::vector<Scanner::Hit> Scanner::scan(const uint8_t *data,size_t size)
+{
+	std::vector<Hit> ret;
+	scan(data,size,[&](const Hit &hit)
+	{
+		ret.push_back(hit);
+	});
+	return ret;
+}
+
 }
 
 }
@@ -44,7 +44,7 @@ const std::string &ARTMDecompressor::getSubName() const noexcept
 // Logically it would decode into null-character (practically it would be instant buffer overflow)
 void ARTMDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
-	class BitReader : public RangeDecoder::BitReader
+	class BitReader
 	{
 	public:
 		BitReader(ForwardInputStream &stream) noexcept:
@@ -54,14 +54,10 @@ void ARTMDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		}
 		~BitReader() noexcept=default;
 
-		uint32_t readBit() final
-		{
-			return _reader.readBits8(1);
-		}
-
+		// range decoder wants the first bit highest
 		uint32_t readBits(uint32_t count)
 		{
-			return _reader.readBits8(count);
+			return rotateBits(_reader.readBits8(count),count);
 		}
 
 	private:
@@ -73,7 +69,7 @@ void ARTMDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	ForwardOutputStream outputStream{rawData,0,rawData.size()};
 	BitReader bitReader{inputStream};
 
-	RangeDecoder decoder{bitReader,uint16_t(rotateBits(bitReader.readBits(16U),16U))};
+	DirectRangeDecoder<BitReader> decoder{bitReader,uint16_t(bitReader.readBits(16U))};
 
 	// first one will never be used, but doing it this way saves us on some nasty arith
 	// on every place later
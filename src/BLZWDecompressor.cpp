@@ -48,10 +48,6 @@ void BLZWDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	};
 
 	ForwardOutputStream outputStream{rawData,0,rawData.size()};
-	auto writeByte=[&](uint8_t value)
-	{
-		outputStream.writeByte(value);
-	};
 
 	uint32_t codeBits{9U};
 	auto readCode=[&]()->uint32_t
@@ -61,7 +57,7 @@ void BLZWDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 
 	uint32_t firstCode=readCode();
 	LZWDecoder decoder{1U<<_maxBits,259U,_stackLength,firstCode};
-	decoder.write(firstCode,false,writeByte);
+	decoder.write(firstCode,false,outputStream);
 
 	while (!outputStream.eof())
 	{
@@ -75,7 +71,7 @@ void BLZWDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 			codeBits=9U;
 			firstCode=readCode();
 			decoder.reset(firstCode);
-			decoder.write(firstCode,false,writeByte);
+			decoder.write(firstCode,false,outputStream);
 			break;
 
 			case 258:
@@ -85,7 +81,7 @@ void BLZWDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 			break;
 
 			default:
-			decoder.write(code,!decoder.isLiteral(code),writeByte);
+			decoder.write(code,!decoder.isLiteral(code),outputStream);
 			decoder.add(code);
 			break;
 		}
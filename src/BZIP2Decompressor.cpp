@@ -7,10 +7,12 @@
 #include "HuffmanDecoder.hpp"
 #include "InputStream.hpp"
 #include "OutputStream.hpp"
-#include "common/MemoryBuffer.hpp"
 #include "common/CRC32.hpp"
 #include "common/Common.hpp"
+#include "common/WrappedVectorBuffer.hpp"
+#include "common/Parallel.hpp"
 
+#include <algorithm>
 #include <array>
 
 namespace ancient::internal
@@ -38,7 +40,8 @@ std::shared_ptr<XPKDecompressor> BZIP2Decompressor::create(uint32_t hdr,uint32_t
 
 BZIP2Decompressor::BZIP2Decompressor(const Buffer &packedData,bool exactSizeKnown,bool verify) :
 	_packedData{packedData},
-	_packedSize{0}
+	_packedSize{0},
+	_exactSizeKnown{exactSizeKnown}
 {
 	uint32_t hdr=packedData.readBE32(0);
 	if (!detectHeader(hdr,0))
@@ -69,6 +72,11 @@ const std::string &BZIP2Decompressor::getSubName() const noexcept
 	return name;
 }
 
+bool BZIP2Decompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 size_t BZIP2Decompressor::getPackedSize() const noexcept
 {
 	// no way to know before decompressing
@@ -83,21 +91,39 @@ size_t BZIP2Decompressor::getRawSize() const noexcept
 }
 
 void BZIP2Decompressor::decompressImpl(Buffer &rawData,bool verify)
+{
+	decompressInternal(rawData,nullptr,verify);
+}
+
+void BZIP2Decompressor::decompressStreamImpl(const OutputSink &sink,bool verify)
+{
+	std::vector<uint8_t> data;
+	WrappedVectorBuffer rawData{data};
+	decompressInternal(rawData,&sink,verify);
+}
+
+void BZIP2Decompressor::decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify)
 {
 	size_t packedSize=_packedSize?_packedSize:_packedData.size();
 
 	ForwardInputStream inputStream{_packedData,4,packedSize};
-	MSBBitReader<ForwardInputStream> bitReader{inputStream};
+	MSBBitReader64<ForwardInputStream> bitReader{inputStream};
 	auto readBits=[&](uint32_t count)->uint32_t
 	{
-		return bitReader.readBits8(count);
+		return bitReader.readBits(count);
 	};
 	auto readBit=[&]()->uint32_t
 	{
-		return bitReader.readBits8(1);
+		return bitReader.readBits(1);
+	};
+	auto peekBits=[&](uint32_t count)->uint32_t
+	{
+		return bitReader.peekBits(count);
+	};
+	auto consumeBits=[&](uint32_t count)
+	{
+		bitReader.consumeBits(count);
 	};
-
-	AutoExpandingForwardOutputStream outputStream{rawData};
 
 	// stream verification
 	//
@@ -108,13 +134,44 @@ void BZIP2Decompressor::decompressImpl(Buffer &rawData,bool verify)
 	// 3. The CRC is the end of the stream and the stream is bit aligned. You
 	//    can't read CRC without decompressing the stream.
 	uint32_t crc=0;
-	auto calculateBlockCRC=[&](size_t blockPos,size_t blockSize)
+	// when streaming, block CRC is calculated from the data going to the sink
+	// and the block is flushed at the end
+	uint32_t streamBlockCRC=0;
+	OutputSink verifySink;
+	if (sink && verify)
+	{
+		verifySink=[&,sink](const Buffer &data)
+		{
+			streamBlockCRC=CRC32Rev(data,0,data.size(),streamBlockCRC);
+			(*sink)(data);
+		};
+		sink=&verifySink;
+	}
+
+	// typical ratio is 3:1 or more
+	AutoExpandingForwardOutputStream outputStream{rawData,sink,0,getRawSizeHint(_exactSizeKnown?packedSize*3U:0)};
+
+	// CRC of the data written since blockPos
+	auto calculateOutputCRC=[&](size_t blockPos)->uint32_t
+	{
+		if (sink)
+		{
+			outputStream.flush();
+			uint32_t ret{streamBlockCRC};
+			streamBlockCRC=0;
+			return ret;
+		} else {
+			return CRC32Rev(rawData,blockPos,outputStream.getOffset()-blockPos,0);
+		}
+	};
+
+	auto addBlockCRC=[&](uint32_t blockCRC)
 	{
 		crc=(crc<<1)|(crc>>31);
-		crc^=CRC32Rev(rawData,blockPos,blockSize,0);
+		crc^=blockCRC;
 	};
 
-	HuffmanDecoder<uint8_t> selectorDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,6> selectorDecoder
 	{
 		// incomplete Huffman table. errors possible
 		HuffmanCode{1,0b000000,uint8_t{0}},
@@ -125,264 +182,360 @@ void BZIP2Decompressor::decompressImpl(Buffer &rawData,bool verify)
 		HuffmanCode{6,0b111110,uint8_t{5}}
 	};
 
-	HuffmanDecoder<int32_t> deltaDecoder
+	static constexpr StaticHuffmanDecoder<int32_t,3> deltaDecoder
 	{
 		HuffmanCode{1,0b00,0},
 		HuffmanCode{2,0b10,1},
 		HuffmanCode{2,0b11,-1}
 	};
 
-	MemoryBuffer tmpBuffer{_blockSize};
+	// Block boundaries are known only after Huffman decoding the block, thus that part is done
+	// sequentially. The inverse BWT + final RLE of the decoded blocks are independent of each other
+	// and they are done in parallel for a batch of blocks when there are workers available.
+	// Batches run on the shared worker pool, so no threads are started per batch. Inside the work of
+	// another forEach (f.e. parallel XPK chunks) there is a single worker and blocks are done one by one
+	struct Block
+	{
+		std::vector<uint8_t>	data;
+		uint32_t		size{0};
+		uint32_t		currentPtr{0};
+		bool			randomized{false};
+		std::vector<uint8_t>	output;
+		uint32_t		crc{0};
+	};
+	// Every block in a batch is kept in memory, so the batch is capped regardless of the worker count
+	uint32_t batchSize{std::min(Parallel::getWorkerCount(),4U)};
+	std::vector<Block> blocks;
+	uint32_t blockCount{0};
 
-	// This is the dark, ancient secret of bzip2.
-	// versions before 0.9.5 had a data randomization for "too regular"
-	// data problematic for the bwt-implementation at that time.
-	// although it is never utilized anymore, the support is still there
-	// And this is exactly the kind of ancient stuff we want to support :)
-	//
-	// On this specific part (since it is a table of magic numbers)
-	// we have no way other than copying it from the original reference
+	auto decodeBlock=[&](Block &block)
+	{
+		// this is rather spaghetti...
+		readBits(32);	// block crc, not interested
+		block.randomized=!!readBit();
 
-// Table has a separate copyright, lets have it as a separate file as well
-#include "BZIP2Table.hpp"
+		uint32_t currentPtr{readBits(24)};
 
-	for (;;)
-	{
-		uint32_t blockHdrHigh{readBits(32)};
-		uint32_t blockHdrLow{readBits(16)};
-		if (blockHdrHigh==0x31415926U && blockHdrLow==0x5359U)
-		{
-			// a block
+		uint32_t currentBlockSize{0};
+		uint32_t numHuffmanItems{2};
+		std::array<uint32_t,256> huffmanValues;
 
-			// this is rather spaghetti...
-			readBits(32);	// block crc, not interested
-			bool randomized{!!readBit()};
+		{
+			// this is just a little bit inefficient but still we reading bit by bit since
+			// reference does it. (bitsream format details do not spill over)
+			std::array<bool,16> usedMap;
+			for (uint32_t i=0;i<16;i++) usedMap[i]=readBit();
 
-			// basically the random inserted is one LSB after n-th bytes
-			// per defined in the table.
-			uint32_t randomPos{1};
-			uint32_t randomCounter{randomTable[0]-1U};
-			auto randomBit=[&]()->bool
+			std::array<bool,256> huffmanMap;
+			for (uint32_t i=0;i<16;i++)
 			{
-				// Beauty is in the eye of the beholder: this is smallest form to hide the ugliness
-				return (!randomCounter--)?randomCounter=randomTable[randomPos++&511]:false;
-			};
+				for (uint32_t j=0;j<16;j++)
+					huffmanMap[i*16+j]=(usedMap[i])?readBit():false;
+			}
+
+			for (uint32_t i=0;i<256;i++) if (huffmanMap[i]) numHuffmanItems++;
+			if (numHuffmanItems==2)
+				throw DecompressionError();
+
+			for (uint32_t currentValue=0,i=0;i<256;i++)
+				if (huffmanMap[i]) huffmanValues[currentValue++]=i;
+		}
+
+		uint32_t huffmanGroups{readBits(3)};
+		if (huffmanGroups<2 || huffmanGroups>6)
+			throw DecompressionError();
+
+		uint32_t selectorsUsed{readBits(15)};
+		if (!selectorsUsed)
+			throw DecompressionError();
 
-			uint32_t currentPtr{readBits(24)};
+		std::vector<uint8_t> huffmanSelectorList(selectorsUsed);
 
-			uint32_t currentBlockSize{0};
+		auto unMTF=[](uint8_t value,auto &map)->uint8_t
+		{
+			uint8_t ret{map[value]};
+			if (value)
 			{
-				uint32_t numHuffmanItems{2};
-				std::array<uint32_t,256> huffmanValues;
+				uint8_t tmp=map[value];
+				for (uint32_t i=value;i;i--)
+					map[i]=map[i-1];
+				map[0]=tmp;
+			}
+			return ret;
+		};
 
-				{
-					// this is just a little bit inefficient but still we reading bit by bit since
-					// reference does it. (bitsream format details do not spill over)
-					std::array<bool,16> usedMap;
-					for (uint32_t i=0;i<16;i++) usedMap[i]=readBit();
+		// create Huffman selectors
+		std::array<uint8_t,6> selectorMTFMap{0,1,2,3,4,5};
 
-					std::array<bool,256> huffmanMap;
-					for (uint32_t i=0;i<16;i++)
-					{
-						for (uint32_t j=0;j<16;j++)
-							huffmanMap[i*16+j]=(usedMap[i])?readBit():false;
-					}
+		for (uint32_t i=0;i<selectorsUsed;i++)
+		{
+			uint8_t item{unMTF(selectorDecoder.decode(readBit),selectorMTFMap)};
+			if (item>=huffmanGroups)
+				throw DecompressionError();
+			huffmanSelectorList[i]=item;
+		}
 
-					for (uint32_t i=0;i<256;i++) if (huffmanMap[i]) numHuffmanItems++;
-					if (numHuffmanItems==2)
-						throw DecompressionError();
+		typedef HuffmanDecoder<uint32_t> BZIP2Decoder;
+		std::vector<BZIP2Decoder> dataDecoders{huffmanGroups};
 
-					for (uint32_t currentValue=0,i=0;i<256;i++)
-						if (huffmanMap[i]) huffmanValues[currentValue++]=i;
-				}
+		// Create all tables
+		for (uint32_t i=0;i<huffmanGroups;i++)
+		{
+			std::array<uint8_t,258> bitLengths;
 
-				uint32_t huffmanGroups{readBits(3)};
-				if (huffmanGroups<2 || huffmanGroups>6)
+			uint32_t currentBits{readBits(5)};
+			for (uint32_t j=0;j<numHuffmanItems;j++)
+			{
+				int32_t delta;
+				do
+				{
+					delta=deltaDecoder.decode(readBit);
+					currentBits+=delta;
+				} while (delta);
+				if (currentBits<1 || currentBits>20)
 					throw DecompressionError();
+				bitLengths[j]=currentBits;
+			}
 
-				uint32_t selectorsUsed{readBits(15)};
-				if (!selectorsUsed)
-					throw DecompressionError();
+			dataDecoders[i].createOrderlyHuffmanTable(bitLengths,numHuffmanItems);
+			dataDecoders[i].createLookupTable(10U,false);
+		}
 
-				std::vector<uint8_t> huffmanSelectorList(selectorsUsed);
+		// Huffman decode + unRLE + unMTF
+		BZIP2Decoder *currentHuffmanDecoder{nullptr};
+		uint32_t currentHuffmanIndex{0};
+		std::array<uint8_t,256> dataMTFMap;
+		for (uint32_t i=0;i<numHuffmanItems-2;i++) dataMTFMap[i]=i;
 
-				auto unMTF=[](uint8_t value,auto &map)->uint8_t
-				{
-					uint8_t ret{map[value]};
-					if (value)
-					{
-						uint8_t tmp=map[value];
-						for (uint32_t i=value;i;i--)
-							map[i]=map[i-1];
-						map[0]=tmp;
-					}
-					return ret;
-				};
+		uint32_t currentRunLength{0};
+		uint32_t currentRLEWeight{1};
 
-				// create Huffman selectors
-				std::array<uint8_t,6> selectorMTFMap{0,1,2,3,4,5};
+		auto decodeRLE=[&]()
+		{
+			if (currentRunLength)
+			{
+				if (currentBlockSize+currentRunLength>_blockSize)
+					throw DecompressionError();
+				for (uint32_t i=0;i<currentRunLength;i++) block.data[currentBlockSize++]=huffmanValues[dataMTFMap[0]];
+			}
+			currentRunLength=0;
+			currentRLEWeight=1;
+		};
 
-				for (uint32_t i=0;i<selectorsUsed;i++)
-				{
-					uint8_t item{unMTF(selectorDecoder.decode(readBit),selectorMTFMap)};
-					if (item>=huffmanGroups)
-						throw DecompressionError();
-					huffmanSelectorList[i]=item;
-				}
+		for (uint32_t streamIndex=0;;streamIndex++)
+		{
+			if (!(streamIndex%50))
+			{
+				if (currentHuffmanIndex>=selectorsUsed)
+					throw DecompressionError();
+				currentHuffmanDecoder=&dataDecoders[huffmanSelectorList[currentHuffmanIndex++]];
+			}
+			uint32_t symbolMTF{currentHuffmanDecoder->decode(peekBits,consumeBits)};
+			// stop marker is referenced only once, and it is the last one
+			// This means we do no have to un-MTF it for detection
+			if (symbolMTF==numHuffmanItems-1) break;
+			if (currentBlockSize>=_blockSize)
+				throw DecompressionError();
+			if (symbolMTF<2)
+			{
+				currentRunLength+=currentRLEWeight<<symbolMTF;
+				currentRLEWeight<<=1;
+			} else {
+				decodeRLE();
+				uint8_t symbol{unMTF(symbolMTF-1,dataMTFMap)};
+				if (currentBlockSize>=_blockSize)
+					throw DecompressionError();
+				block.data[currentBlockSize++]=huffmanValues[symbol];
+			}
+		}
+		decodeRLE();
+		if (currentPtr>=currentBlockSize)
+			throw DecompressionError();
+		block.size=currentBlockSize;
+		block.currentPtr=currentPtr;
+	};
 
-				typedef HuffmanDecoder<uint32_t> BZIP2Decoder;
-				std::vector<BZIP2Decoder> dataDecoders{huffmanGroups};
+	// This is the dark, ancient secret of bzip2.
+	// versions before 0.9.5 had a data randomization for "too regular"
+	// data problematic for the bwt-implementation at that time.
+	// although it is never utilized anymore, the support is still there
+	// And this is exactly the kind of ancient stuff we want to support :)
+	//
+	// On this specific part (since it is a table of magic numbers)
+	// we have no way other than copying it from the original reference
 
-				// Create all tables
-				for (uint32_t i=0;i<huffmanGroups;i++)
-				{
-					std::array<uint8_t,258> bitLengths;
+// Table has a separate copyright, lets have it as a separate file as well
+#include "BZIP2Table.hpp"
 
-					uint32_t currentBits{readBits(5)};
-					for (uint32_t j=0;j<numHuffmanItems;j++)
-					{
-						int32_t delta;
-						do
-						{
-							delta=deltaDecoder.decode(readBit);
-							currentBits+=delta;
-						} while (delta);
-						if (currentBits<1 || currentBits>20)
-							throw DecompressionError();
-						bitLengths[j]=currentBits;
-					}
+	// inverse BWT + final RLE decoding.
+	// there are a few dark corners here as well
+	// 1. Can the stream end at 4 literals without count? I assume it is a valid optimization (and that this does not spillover to next block)
+	// 2. Can the RLE-step include counts 252 to 255 even if reference does not do them? I assume yes here as here as well
+	// 3. Can the stream be empty? We do not take issue here about that (that should be culled out earlier already)
+	auto inverseBWT=[&](Block &block,auto writeByte)
+	{
+		// basically the random inserted is one LSB after n-th bytes
+		// per defined in the table.
+		uint32_t randomPos{1};
+		uint32_t randomCounter{randomTable[0]-1U};
+		auto randomBit=[&]()->bool
+		{
+			// Beauty is in the eye of the beholder: this is smallest form to hide the ugliness
+			return (!randomCounter--)?randomCounter=randomTable[randomPos++&511]:false;
+		};
 
-					dataDecoders[i].createOrderlyHuffmanTable(bitLengths,numHuffmanItems);
-				}
+		uint8_t *tmpBuffer{block.data.data()};
+		uint32_t currentBlockSize{block.size};
+		uint32_t currentPtr{block.currentPtr};
 
-				// Huffman decode + unRLE + unMTF
-				BZIP2Decoder *currentHuffmanDecoder{nullptr};
-				uint32_t currentHuffmanIndex{0};
-				std::array<uint8_t,256> dataMTFMap;
-				for (uint32_t i=0;i<numHuffmanItems-2;i++) dataMTFMap[i]=i;
+		std::array<uint32_t,256> sums;
+		for (uint32_t i=0;i<256;i++) sums[i]=0;
 
-				uint32_t currentRunLength{0};
-				uint32_t currentRLEWeight{1};
+		for (uint32_t i=0;i<currentBlockSize;i++)
+			sums[tmpBuffer[i]]++;
 
-				auto decodeRLE=[&]()
+		std::array<uint32_t,256> rank;
+		for (uint32_t tot=0,i=0;i<256;i++)
+		{
+			rank[i]=tot;
+			tot+=sums[i];
+		}
+
+		// Walking the BWT is a chain of dependent random loads, i.e. cache misses.
+		// To make it faster:
+		// 1. Symbol is packed into the low 8 bits of the index (block size is less than 2^24)
+		//    so that there is only one load per byte
+		// 2. Both the forward table and its inverse (LF-mapping) are built. First half of the block
+		//    is walked forwards and the second half backwards from the end at the same time.
+		//    Two independent chains lets the CPU have 2 misses in flight
+		// This costs 8*size of memory, but the data is decoded in-place into tmpBuffer
+		std::vector<uint32_t> forwardIndex(currentBlockSize);
+		std::vector<uint32_t> backwardIndex(currentBlockSize);
+		for (uint32_t i=0;i<currentBlockSize;i++)
+		{
+			uint8_t ch{tmpBuffer[i]};
+			uint32_t pos{rank[ch]++};
+			forwardIndex[pos]=(i<<8)|ch;
+			backwardIndex[i]=(pos<<8)|ch;
+		}
+
+		uint32_t forwardLength{currentBlockSize-currentBlockSize/2};
+		uint32_t forwardPtr{currentPtr};
+		uint32_t backwardPtr{currentPtr};
+		uint32_t forwardPos{0};
+		for (uint32_t backwardPos=currentBlockSize;backwardPos>forwardLength;forwardPos++)
+		{
+			uint32_t forwardValue{forwardIndex[forwardPtr]};
+			uint32_t backwardValue{backwardIndex[backwardPtr]};
+			forwardPtr=forwardValue>>8;
+			backwardPtr=backwardValue>>8;
+			tmpBuffer[forwardPos]=uint8_t(forwardValue);
+			tmpBuffer[--backwardPos]=uint8_t(backwardValue);
+		}
+		if (forwardPos<forwardLength)
+			tmpBuffer[forwardPos]=uint8_t(forwardIndex[forwardPtr]);
+
+		// output + final RLE decoding
+		uint8_t currentCh{0};
+		uint32_t currentChCount{0};
+		auto outputByte=[&](uint8_t ch)
+		{
+			if (block.randomized && randomBit()) ch^=1;
+			if (!currentChCount)
+			{
+				currentCh=ch;
+				currentChCount=1;
+			} else {
+				if (ch==currentCh && currentChCount!=4)
 				{
-					if (currentRunLength)
+					currentChCount++;
+				} else {
+					auto outputBlock=[&](uint32_t count)
 					{
-						if (currentBlockSize+currentRunLength>_blockSize)
-							throw DecompressionError();
-						for (uint32_t i=0;i<currentRunLength;i++) tmpBuffer[currentBlockSize++]=huffmanValues[dataMTFMap[0]];
-					}
-					currentRunLength=0;
-					currentRLEWeight=1;
-				};
+						for (uint32_t i=0;i<count;i++) writeByte(currentCh);
+					};
 
-				for (uint32_t streamIndex=0;;streamIndex++)
-				{
-					if (!(streamIndex%50))
+					if (currentChCount==4)
 					{
-						if (currentHuffmanIndex>=selectorsUsed)
-							throw DecompressionError();
-						currentHuffmanDecoder=&dataDecoders[huffmanSelectorList[currentHuffmanIndex++]];
-					}
-					uint32_t symbolMTF{currentHuffmanDecoder->decode(readBit)};
-					// stop marker is referenced only once, and it is the last one
-					// This means we do no have to un-MTF it for detection
-					if (symbolMTF==numHuffmanItems-1) break;
-					if (currentBlockSize>=_blockSize)
-						throw DecompressionError();
-					if (symbolMTF<2)
-					{
-						currentRunLength+=currentRLEWeight<<symbolMTF;
-						currentRLEWeight<<=1;
+						outputBlock(uint32_t(ch)+4);
+						currentChCount=0;
 					} else {
-						decodeRLE();
-						uint8_t symbol{unMTF(symbolMTF-1,dataMTFMap)};
-						if (currentBlockSize>=_blockSize)
-							throw DecompressionError();
-						tmpBuffer[currentBlockSize++]=huffmanValues[symbol];
+						outputBlock(currentChCount);
+						currentCh=ch;
+						currentChCount=1;
 					}
 				}
-				decodeRLE();
-				if (currentPtr>=currentBlockSize)
-					throw DecompressionError();
 			}
+		};
 
-			// inverse BWT + final RLE decoding.
-			// there are a few dark corners here as well
-			// 1. Can the stream end at 4 literals without count? I assume it is a valid optimization (and that this does not spillover to next block)
-			// 2. Can the RLE-step include counts 252 to 255 even if reference does not do them? I assume yes here as here as well
-			// 3. Can the stream be empty? We do not take issue here about that (that should be culled out earlier already)
-			std::array<uint32_t,256> sums;
-			for (uint32_t i=0;i<256;i++) sums[i]=0;
-
-			for (uint32_t i=0;i<currentBlockSize;i++)
-				sums[tmpBuffer[i]]++;
+		// and now the final unRLE is easy...
+		for (uint32_t i=0;i<currentBlockSize;i++)
+			outputByte(tmpBuffer[i]);
+		// cleanup the state, a bit hackish way to do it
+		if (currentChCount) outputByte(currentChCount==4?0:~currentCh);
+	};
 
-			std::array<uint32_t,256> rank;
-			for (uint32_t tot=0,i=0;i<256;i++)
+	auto processBlocks=[&]()
+	{
+		if (blockCount==1U)
+		{
+			// no need for the intermediate buffer
+			size_t destOffsetStart{outputStream.getOffset()};
+			inverseBWT(blocks[0],[&](uint8_t ch)
 			{
-				rank[i]=tot;
-				tot+=sums[i];
-			}
-
-			// not at all happy about the memory consumption, but it simplifies the implementation a lot
-			// and by sacrificing 4*size (size as in actual block size) we do not have to have slow search nor another temporary buffer
-			// since by calculating forward table we can do forward decoding of the data on the same pass as iBWT
-			//
-			// also, because I'm lazy
-			std::vector<uint32_t> forwardIndex(currentBlockSize);
-			for (uint32_t i=0;i<currentBlockSize;i++)
-				forwardIndex[rank[tmpBuffer[i]]++]=i;
-
-			// output + final RLE decoding
-			uint8_t currentCh{0};
-			uint32_t currentChCount{0};
-			auto outputByte=[&](uint8_t ch)
+				outputStream.writeByte(ch);
+			});
+			if (verify)
+				addBlockCRC(calculateOutputCRC(destOffsetStart));
+		} else if (blockCount) {
+			Parallel::forEach(blockCount,[&](size_t i)
 			{
-				if (randomized && randomBit()) ch^=1;
-				if (!currentChCount)
+				Block &block{blocks[i]};
+				block.output.clear();
+				// final RLE makes the output typically about the size of the block
+				block.output.reserve(block.size);
+				inverseBWT(block,[&](uint8_t ch)
 				{
-					currentCh=ch;
-					currentChCount=1;
-				} else {
-					if (ch==currentCh && currentChCount!=4)
-					{
-						currentChCount++;
-					} else {
-						auto outputBlock=[&](uint32_t count)
-						{
-							for (uint32_t i=0;i<count;i++) outputStream.writeByte(currentCh);
-						};
-
-						if (currentChCount==4)
-						{
-							outputBlock(uint32_t(ch)+4);
-							currentChCount=0;
-						} else {
-							outputBlock(currentChCount);
-							currentCh=ch;
-							currentChCount=1;
-						}
-					}
+					if (block.output.size()>=Decompressor::getMaxRawSize())
+						throw DecompressionError();
+					block.output.push_back(ch);
+				});
+				if (verify && !sink)
+				{
+					WrappedVectorBuffer output{block.output};
+					block.crc=CRC32Rev(output,0,output.size(),0);
 				}
-			};
-
-			size_t destOffsetStart{outputStream.getOffset()};
-
-			// and now the final iBWT + unRLE is easy...
-			for (uint32_t i=0;i<currentBlockSize;i++)
+			});
+			for (uint32_t i=0;i<blockCount;i++)
 			{
-				currentPtr=forwardIndex[currentPtr];
-				outputByte(tmpBuffer[currentPtr]);
+				size_t destOffsetStart{outputStream.getOffset()};
+				WrappedVectorBuffer output{blocks[i].output};
+				outputStream.produce(output);
+				if (verify)
+					addBlockCRC(sink?calculateOutputCRC(destOffsetStart):blocks[i].crc);
 			}
-			// cleanup the state, a bit hackish way to do it
-			if (currentChCount) outputByte(currentChCount==4?0:~currentCh);
-
-			if (verify)
-				calculateBlockCRC(destOffsetStart,outputStream.getOffset()-destOffsetStart);
+		}
+		blockCount=0;
+	};
 
+	for (;;)
+	{
+		uint32_t blockHdrHigh{readBits(32)};
+		uint32_t blockHdrLow{readBits(16)};
+		if (blockHdrHigh==0x31415926U && blockHdrLow==0x5359U)
+		{
+			// a block
+			if (blockCount==blocks.size())
+			{
+				blocks.emplace_back();
+				blocks.back().data.resize(_blockSize);
+			}
+			decodeBlock(blocks[blockCount++]);
+			if (blockCount==batchSize)
+				processBlocks();
 		} else if (blockHdrHigh==0x17724538U && blockHdrLow==0x5090U) {
 			// end of blocks
+			processBlocks();
 			uint32_t rawCRC{readBits(32)};
 			if (verify && crc!=rawCRC)
 				throw VerificationError();
@@ -390,6 +543,9 @@ void BZIP2Decompressor::decompressImpl(Buffer &rawData,bool verify)
 		} else throw DecompressionError();
 	}
 
+	// return the read-ahead bytes
+	bitReader.reset();
+	outputStream.flush();
 	_rawSize=outputStream.getOffset();
 	_packedSize=inputStream.getOffset();
 }
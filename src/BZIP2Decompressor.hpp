@@ -21,8 +21,10 @@ public:
 
 	const std::string &getName() const noexcept final;
 	const std::string &getSubName() const noexcept final;
+	bool isChunkIndependent() const noexcept final;
 
 	void decompressImpl(Buffer &rawData,bool verify) final;
+	void decompressStreamImpl(const OutputSink &sink,bool verify) final;
 	void decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify) final;
 
 	static bool detectHeader(uint32_t hdr,uint32_t footer) noexcept;
@@ -32,10 +34,13 @@ public:
 	static std::shared_ptr<XPKDecompressor> create(uint32_t hdr,uint32_t recursionLevel,const Buffer &packedData,std::shared_ptr<XPKDecompressor::State> &state,bool verify);
 
 private:
+	void decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify);
+
 	const Buffer		&_packedData;
 
 	size_t			_blockSize{0};
 	size_t			_packedSize{0};
+	bool			_exactSizeKnown{true};
 	size_t			_rawSize{0};
 };
 
@@ -227,7 +227,7 @@ void ByteKillerDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		}
 	}
 
-	HuffmanDecoder<uint32_t> decoder
+	static constexpr StaticHuffmanDecoder<uint32_t,6> decoder
 	{
 		HuffmanCode{2,0b000,0U},
 		HuffmanCode{2,0b001,1U},
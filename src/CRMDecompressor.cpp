@@ -197,7 +197,7 @@ void CRMDecompressor::decompressImpl(Buffer &rawData,bool verify)
 			}
 		} while (readBit());
 	} else {
-		HuffmanDecoder<uint8_t> lengthDecoder
+		static constexpr StaticHuffmanDecoder<uint8_t,4> lengthDecoder
 		{
 			HuffmanCode{1,0b000,uint8_t{0}},
 			HuffmanCode{2,0b010,uint8_t{1}},
@@ -205,7 +205,7 @@ void CRMDecompressor::decompressImpl(Buffer &rawData,bool verify)
 			HuffmanCode{3,0b111,uint8_t{3}}
 		};
 
-		HuffmanDecoder<uint8_t> distanceDecoder
+		static constexpr StaticHuffmanDecoder<uint8_t,3> distanceDecoder
 		{
 			HuffmanCode{1,0b00,uint8_t{1}},
 			HuffmanCode{2,0b10,uint8_t{0}},
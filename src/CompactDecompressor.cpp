@@ -61,19 +61,24 @@ void CompactDecompressor::decompressImpl(Buffer &rawData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,2U,_packedSize?_packedSize:_packedData.size()};
 
-	MSBBitReader<ForwardInputStream> bitReader{inputStream};
+	MSBBitReader64<ForwardInputStream> bitReader{inputStream};
 	auto readBits=[&](uint32_t count)->uint32_t
 	{
-		return bitReader.readBits8(count);
+		return bitReader.readBits(count);
 	};
-	auto readBit=[&]()->uint32_t
+	auto peekBits=[&](uint32_t count)->uint32_t
 	{
 		// left is right and right is left
-		return bitReader.readBits8(1U)^1U;
+		return bitReader.peekBits(count)^((1U<<count)-1U);
+	};
+	auto consumeBits=[&](uint32_t count)
+	{
+		bitReader.consumeBits(count);
 	};
 
-	AutoExpandingForwardOutputStream outputStream{rawData};
+	AutoExpandingForwardOutputStream outputStream{rawData,nullptr,0,getRawSizeHint(0)};
 	DynamicHuffmanDecoder<258U> decoder{3U};
+	decoder.createLookupTable(8U,false);
 	uint32_t codeCount{0};
 	std::array<uint16_t,258> mapper;
 
@@ -85,7 +90,7 @@ void CompactDecompressor::decompressImpl(Buffer &rawData,bool verify)
 
 	for(;;)
 	{
-		uint32_t code{decoder.decode(readBit)};
+		uint32_t code{decoder.decode(peekBits,consumeBits)};
 		decoder.update(code);
 		code=mapper[code];
 		if (code==257U)
@@ -98,6 +103,7 @@ void CompactDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		} else if (code==256U) break;
 		outputStream.writeByte(code);
 	}
+	bitReader.reset();
 	_rawSize=outputStream.getOffset();
 	if (_exactSizeKnown && inputStream.getOffset()!=_packedSize)
 		throw DecompressionError();
@@ -5,6 +5,7 @@
 #include "InputStream.hpp"
 #include "OutputStream.hpp"
 #include "common/Common.hpp"
+#include "common/WrappedVectorBuffer.hpp"
 
 
 namespace ancient::internal
@@ -61,6 +62,18 @@ size_t CompressDecompressor::getRawSize() const noexcept
 }
 
 void CompressDecompressor::decompressImpl(Buffer &rawData,bool verify)
+{
+	decompressInternal(rawData,nullptr,verify);
+}
+
+void CompressDecompressor::decompressStreamImpl(const OutputSink &sink,bool verify)
+{
+	std::vector<uint8_t> data;
+	WrappedVectorBuffer rawData{data};
+	decompressInternal(rawData,&sink,verify);
+}
+
+void CompressDecompressor::decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify)
 {
 	// Special case for empty file
 	if (_packedData.size()==3U)
@@ -76,18 +89,15 @@ void CompressDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		return bitReader.readBits8(count);
 	};
 
-	AutoExpandingForwardOutputStream outputStream{rawData};
-	auto writeByte=[&](uint8_t value)
-	{
-		outputStream.writeByte(value);
-	};
+	// LZW typically packs 2:1 or more
+	AutoExpandingForwardOutputStream outputStream{rawData,sink,0,getRawSizeHint(_packedData.size()*2U)};
 
 	uint32_t codeBits{9U};
 	size_t prevCodePos=inputStream.getOffset();
 
 	uint32_t firstCode{readBits(codeBits)};
 	LZWDecoder decoder{1U<<_maxBits,_hasBlocks?257U:256U,8192U,firstCode};
-	decoder.write(firstCode,false,writeByte);
+	decoder.write(firstCode,false,outputStream);
 
 	// This is actually surprising for a compressor
 	// that was popular at time: There are silly bugs
@@ -138,13 +148,14 @@ void CompressDecompressor::decompressImpl(Buffer &rawData,bool verify)
 			firstCode=readBits(codeBits);
 			codeCounter++;
 			decoder.reset(firstCode);
-			decoder.write(firstCode,false,writeByte);
+			decoder.write(firstCode,false,outputStream);
 		} else {
-			decoder.write(code,!decoder.isLiteral(code),writeByte);
+			decoder.write(code,!decoder.isLiteral(code),outputStream);
 			decoder.add(code);
 		}
 	}
 
+	outputStream.flush();
 	_rawSize=outputStream.getOffset();
 }
 
@@ -11,18 +11,20 @@
 #include "common/CRC32.hpp"
 #include "common/OverflowCheck.hpp"
 #include "common/Common.hpp"
+#include "common/WrappedVectorBuffer.hpp"
 
 #include <array>
 
 namespace ancient::internal
 {
 
-static uint32_t Adler32(const Buffer &buffer,size_t offset,size_t len)
+static uint32_t Adler32(const Buffer &buffer,size_t offset,size_t len,uint32_t accumulator)
 {
-	uint32_t s1=1,s2=0;
+	uint32_t s1=accumulator&0xffffU,s2=accumulator>>16;
+	const uint8_t *src{buffer.view(offset,len)};
 	for (size_t i=0;i<len;i++)
 	{
-		s1+=buffer[offset+i];
+		s1+=src[i];
 		if (s1>=65521) s1-=65521;
 		s2+=s1;
 		if (s2>=65521) s2-=65521;
@@ -194,6 +196,11 @@ const std::string &DEFLATEDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool DEFLATEDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 size_t DEFLATEDecompressor::getPackedSize() const noexcept
 {
 	// no way to know before decompressing
@@ -208,21 +215,55 @@ size_t DEFLATEDecompressor::getRawSize() const noexcept
 }
 
 void DEFLATEDecompressor::decompressImpl(Buffer &rawData,bool verify)
+{
+	decompressInternal(rawData,nullptr,verify);
+}
+
+void DEFLATEDecompressor::decompressStreamImpl(const OutputSink &sink,bool verify)
+{
+	std::vector<uint8_t> data;
+	WrappedVectorBuffer rawData{data};
+	decompressInternal(rawData,&sink,verify);
+}
+
+void DEFLATEDecompressor::decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify)
 {
 	size_t packedSize{_packedSize?_packedSize:_packedData.size()};
 
 	ForwardInputStream inputStream{_packedData,_packedOffset,packedSize};
-	LSBBitReader<ForwardInputStream> bitReader{inputStream};
+	LSBBitReader64<ForwardInputStream> bitReader{inputStream};
 	auto readBits=[&](uint32_t count)->uint32_t
 	{
-		return bitReader.readBits8(count);
+		return bitReader.readBits(count);
 	};
 	auto readBit=[&]()->uint32_t
 	{
-		return bitReader.readBits8(1);
+		return bitReader.readBits(1);
+	};
+	auto peekBits=[&](uint32_t count)->uint32_t
+	{
+		return bitReader.peekBits(count);
+	};
+	auto consumeBits=[&](uint32_t count)
+	{
+		bitReader.consumeBits(count);
 	};
 
-	AutoExpandingForwardOutputStream outputStream{rawData};
+	// streaming needs running checksum
+	uint32_t checksum{(_type==Type::ZLib)?1U:0};
+	OutputSink verifySink;
+	if (sink && verify)
+	{
+		verifySink=[&,sink](const Buffer &data)
+		{
+			if (_type==Type::ZLib) checksum=Adler32(data,0,data.size(),checksum);
+				else checksum=CRC32(data,0,data.size(),checksum);
+			(*sink)(data);
+		};
+		sink=&verifySink;
+	}
+	// gzip has the raw size in the trailer
+	AutoExpandingForwardOutputStream outputStream{rawData,sink,_deflate64?65536U:32768U,getRawSizeHint(_rawSize)};
 
 
 	VariableLengthCodeDecoder lengthVLC{
@@ -243,6 +284,60 @@ void DEFLATEDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		 7, 7, 8, 8, 9, 9,10,10,
 		11,11,12,12,13,13,14,14};
 
+	// Fixed Huffman tables of block type 1, built at compile time
+	static constexpr StaticHuffmanDecoder<uint32_t,288U,9U,true> fixedLLDecoder{StaticHuffmanDecoder<uint32_t,288U,9U,true>::createOrderly([]()
+	{
+		std::array<uint8_t,288U> ret{};
+		for (uint32_t i=0;i<288U;i++) ret[i]=(i<144U)?8U:(i<256U)?9U:(i<280U)?7U:8U;
+		return ret;
+	}())};
+	static constexpr StaticHuffmanDecoder<uint32_t,32U,5U,true> fixedDistanceDecoder{StaticHuffmanDecoder<uint32_t,32U,5U,true>::createOrderly([]()
+	{
+		std::array<uint8_t,32U> ret{};
+		for (uint32_t i=0;i<32U;i++) ret[i]=5U;
+		return ret;
+	}())};
+
+	auto decodeBlock=[&](const auto &llDecoder,const auto &distanceDecoder)
+	{
+		// and now decode. Space for the longest match is reserved ahead so that
+		// the output can be written without checks
+		size_t space{0};
+		for (;;)
+		{
+			if (space<258U) space=outputStream.reserve(258U);
+			if (uint32_t code{llDecoder.decode(peekBits,consumeBits)};code<256U) {
+				if (space)
+				{
+					outputStream.writeByteUnchecked(code);
+					space--;
+				} else outputStream.writeByte(code);
+			} else if (code==256U) {
+				break;
+			} else {
+				uint32_t count;
+				if (_deflate64&&code==285U)
+				{
+					count=readBits(16U)+3U;
+				} else {
+					count=lengthVLC.decode(readBits,code-257U)+3U;
+					// two different ways to encode 258, vlc would like to have 259 for the second one
+					if (count==259U) count=258U;
+				};
+				uint32_t distCode{distanceDecoder.decode(peekBits,consumeBits)};
+				uint32_t distance{(_deflate64?distanceVLC64.decode(readBits,distCode):distanceVLC.decode(readBits,distCode))+1U};
+				if (count<=space)
+				{
+					outputStream.copyUnchecked(distance,count);
+					space-=count;
+				} else {
+					outputStream.copy(distance,count);
+					space=0;
+				}
+			}
+		}
+	};
+
 	bool final;
 	do {
 		final=readBit();
@@ -257,115 +352,90 @@ void DEFLATEDecompressor::decompressImpl(Buffer &rawData,bool verify)
 			if (len!=(nlen^0xffffU))
 				throw DecompressionError();
 			outputStream.produce(*inputStream.consume(len));
-		} else if (blockType==1 || blockType==2) {
+		} else if (blockType==1) {
+			decodeBlock(fixedLLDecoder,fixedDistanceDecoder);
+		} else if (blockType==2) {
 			typedef HuffmanDecoder<uint32_t> DEFLATEDecoder;
 			DEFLATEDecoder llDecoder;
 			DEFLATEDecoder distanceDecoder;
 
-			if (blockType==1)
+			uint32_t hlit=readBits(5)+257;
+			// lets just error here, it is simpler
+			if (hlit>286)
+				throw DecompressionError();
+			uint32_t hdist{readBits(5)+1};
+			uint32_t hclen{readBits(4)+4};
+
+			std::array<uint8_t,19> lengthTable;
+			for (uint32_t i=0;i<19;i++) lengthTable[i]=0;
+			const std::array<uint8_t,19> lengthTableOrder={
+				16,17,18, 0, 8, 7, 9, 6,
+				10, 5,11, 4,12, 3,13, 2,
+				14, 1,15};
+			for (uint32_t i=0;i<hclen;i++)
+				lengthTable[lengthTableOrder[i]]=readBits(3);
+
+			DEFLATEDecoder bitLengthDecoder;
+			bitLengthDecoder.createOrderlyHuffmanTable(lengthTable,19); // 19 and not hclen due to reordering
+
+			// can the previous code flow from ll to distance table?
+			// specification does not say and treats the two almost as combined.
+			// So let previous code flow
+
+			std::array<uint8_t,286> llTableBits;
+			std::array<uint8_t,32> distanceTableBits;
+
+			uint8_t prevValue{0};
+			uint32_t i{0};
+			while (i<hlit+hdist)
 			{
-				for (uint32_t i=0;i<24;i++) llDecoder.insert(HuffmanCode{7,i,i+256});
-				for (uint32_t i=0;i<144;i++) llDecoder.insert(HuffmanCode{8,i+0x30,i});
-				for (uint32_t i=0;i<8;i++) llDecoder.insert(HuffmanCode{8,i+0xc0,i+280});
-				for (uint32_t i=0;i<112;i++) llDecoder.insert(HuffmanCode{9,i+0x190,i+144});
-
-				for (uint32_t i=0;i<32;i++) distanceDecoder.insert(HuffmanCode{5,i,i});
-			} else {
-				uint32_t hlit=readBits(5)+257;
-				// lets just error here, it is simpler
-				if (hlit>286)
-					throw DecompressionError();
-				uint32_t hdist{readBits(5)+1};
-				uint32_t hclen{readBits(4)+4};
-
-				std::array<uint8_t,19> lengthTable;
-				for (uint32_t i=0;i<19;i++) lengthTable[i]=0;
-				const std::array<uint8_t,19> lengthTableOrder={
-					16,17,18, 0, 8, 7, 9, 6,
-					10, 5,11, 4,12, 3,13, 2,
-					14, 1,15};
-				for (uint32_t i=0;i<hclen;i++)
-					lengthTable[lengthTableOrder[i]]=readBits(3);
-
-				DEFLATEDecoder bitLengthDecoder;
-				bitLengthDecoder.createOrderlyHuffmanTable(lengthTable,19); // 19 and not hclen due to reordering
-
-				// can the previous code flow from ll to distance table?
-				// specification does not say and treats the two almost as combined.
-				// So let previous code flow
-
-				std::array<uint8_t,286> llTableBits;
-				std::array<uint8_t,32> distanceTableBits;
-
-				uint8_t prevValue{0};
-				uint32_t i{0};
-				while (i<hlit+hdist)
+				auto insert=[&](uint8_t value)
 				{
-					auto insert=[&](uint8_t value)
-					{
-						if (i>=hlit+hdist)
-							throw DecompressionError();
-						if (i>=hlit) distanceTableBits[i-hlit]=value;
-							else llTableBits[i]=value;
-						prevValue=value;
-						i++;
-					};
-
-					if (uint32_t code{bitLengthDecoder.decode(readBit)};code<16U) {
-						insert(code);
-					} else switch (code) {
-						case 16U:
-						if (i) 
-						{
-							uint32_t count{readBits(2U)+3U};
-							for (uint32_t j=0;j<count;j++) insert(prevValue);
-						} else throw DecompressionError();
-						break;
-
-						case 17U:
-						for (uint32_t count=readBits(3U)+3U;count;count--) insert(0);
-						break;
-
-						case 18U:
-						for (uint32_t count=readBits(7U)+11U;count;count--) insert(0);
-						break;
-
-						default:
+					if (i>=hlit+hdist)
 						throw DecompressionError();
-					}
-					
-				}
+					if (i>=hlit) distanceTableBits[i-hlit]=value;
+						else llTableBits[i]=value;
+					prevValue=value;
+					i++;
+				};
+
+				if (uint32_t code{bitLengthDecoder.decode(readBit)};code<16U) {
+					insert(code);
+				} else switch (code) {
+					case 16U:
+					if (i) 
+					{
+						uint32_t count{readBits(2U)+3U};
+						for (uint32_t j=0;j<count;j++) insert(prevValue);
+					} else throw DecompressionError();
+					break;
 
-				llDecoder.createOrderlyHuffmanTable(llTableBits,hlit);
-				distanceDecoder.createOrderlyHuffmanTable(distanceTableBits,hdist);
-			}
+					case 17U:
+					for (uint32_t count=readBits(3U)+3U;count;count--) insert(0);
+					break;
 
-			// and now decode
-			for (;;)
-			{
-				if (uint32_t code{llDecoder.decode(readBit)};code<256U) {
-					outputStream.writeByte(code);
-				} else if (code==256U) {
+					case 18U:
+					for (uint32_t count=readBits(7U)+11U;count;count--) insert(0);
 					break;
-				} else {
-					uint32_t count;
-					if (_deflate64&&code==285U)
-					{
-						count=readBits(16U)+3U;
-					} else {
-						count=lengthVLC.decode(readBits,code-257U)+3U;
-						// two different ways to encode 258, vlc would like to have 259 for the second one
-						if (count==259U) count=258U;
-					};
-					uint32_t distCode{distanceDecoder.decode(readBit)};
-					uint32_t distance{(_deflate64?distanceVLC64.decode(readBits,distCode):distanceVLC.decode(readBits,distCode))+1U};
-					outputStream.copy(distance,count);
+
+					default:
+					throw DecompressionError();
 				}
+				
 			}
+
+			llDecoder.createOrderlyHuffmanTable(llTableBits,hlit);
+			distanceDecoder.createOrderlyHuffmanTable(distanceTableBits,hdist);
+			llDecoder.createLookupTable(10U,true);
+			distanceDecoder.createLookupTable(8U,true);
+			decodeBlock(llDecoder,distanceDecoder);
 		} else {
 			throw DecompressionError();
 		}
 	} while (!final);
+	// return the read-ahead bytes
+	bitReader.reset();
+	outputStream.flush();
 
 	_rawSize=outputStream.getOffset();
 	if (_type==Type::GZIP || _type==Type::Quasijarus)
@@ -386,11 +456,11 @@ void DEFLATEDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		if (_type==Type::GZIP || _type==Type::Quasijarus)
 		{
 			uint32_t crc{_packedData.readLE32(inputStream.getOffset())};
-			if (CRC32(rawData,0,_rawSize,0)!=crc)
+			if ((sink?checksum:CRC32(rawData,0,_rawSize,0))!=crc)
 				throw VerificationError();
 		} else if (_type==Type::ZLib) {
 			uint32_t adler{_packedData.readBE32(inputStream.getOffset())};
-			if (Adler32(rawData,0,_rawSize)!=adler)
+			if ((sink?checksum:Adler32(rawData,0,_rawSize,1U))!=adler)
 				throw VerificationError();
 		}
 	}
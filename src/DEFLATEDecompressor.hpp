@@ -22,8 +22,10 @@ public:
 
 	const std::string &getName() const noexcept final;
 	const std::string &getSubName() const noexcept final;
+	bool isChunkIndependent() const noexcept final;
 
 	void decompressImpl(Buffer &rawData,bool verify) final;
+	void decompressStreamImpl(const OutputSink &sink,bool verify) final;
 	void decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify) final;
 
 	static bool detectHeader(uint32_t hdr,uint32_t footer) noexcept;
@@ -33,6 +35,8 @@ public:
 	static std::shared_ptr<XPKDecompressor> create(uint32_t hdr,uint32_t recursionLevel,const Buffer &packedData,std::shared_ptr<XPKDecompressor::State> &state,bool verify);
 
 private:
+	void decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify);
+
 	bool detectZLib();
 
 	enum class Type
@@ -36,10 +36,12 @@ const std::string &DLTADecode::getSubName() const noexcept
 void DLTADecode::decode(Buffer &bufferDest,const Buffer &bufferSrc,size_t offset,size_t size)
 {
 	uint8_t ctr{0};
+	const uint8_t *src{bufferSrc.view(offset,size)};
+	uint8_t *dest{bufferDest.view(offset,size)};
 	for (size_t i=0;i<size;i++)
 	{
-		ctr+=bufferSrc[offset+i];
-		bufferDest[offset+i]=ctr;
+		ctr+=src[i];
+		dest[i]=ctr;
 	}
 }
 
@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
+#include <array>
 
 #include "DMSDecompressor.hpp"
 
@@ -13,6 +15,7 @@
 #include "common/MemoryBuffer.hpp"
 #include "common/CRC16.hpp"
 #include "common/OverflowCheck.hpp"
+#include "common/Parallel.hpp"
 #include "common/Common.hpp"
 
 
@@ -149,15 +152,41 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify)
 	uint32_t restartPosition{0};
 	if (!_isObsfuscated)
 	{
-		decompressImpl(rawData,verify,restartPosition);
+		// independent track chains can be decompressed in parallel, each with their own context
+		std::vector<TrackChain> chains;
+		if (Parallel::getWorkerCount()>1U) chains=planTrackChains();
+		if (chains.size()>1U)
+		{
+			if (rawData.size()<_rawSize)
+				throw DecompressionError();
+			// fill unused tracks with zeros
+			std::memset(rawData.data(),0,_rawSize);
+			Parallel::forEach(chains.size(),[&](size_t i)
+			{
+				uint32_t chainRestartPosition{0};
+				decompressImpl(rawData,verify,chainRestartPosition,&chains[i],nullptr);
+			});
+		} else decompressImpl(rawData,verify,restartPosition,nullptr,nullptr);
 	} else {
+		// no need to search again if we have already found the key
+		bool keyKnown{_keyPosition!=~0U};
+		if (keyKnown) restartPosition=_keyPosition;
 		while (restartPosition<0x20000U)
 		{
+			// finding the candidate is the slow part, run the search on all the workers.
+			// the full run below will then succeed on the first candidate it tries
+			if (!keyKnown && Parallel::getWorkerCount()>1U)
+			{
+				restartPosition=findKeyPosition(restartPosition);
+				if (restartPosition>=0x20000U) break;
+			}
+			keyKnown=false;
 			// more than single run here is really rare. It means that first track CRC succeeds
 			// but later something else fails
 			try
 			{
-				decompressImpl(rawData,verify,restartPosition);
+				decompressImpl(rawData,verify,restartPosition,nullptr,nullptr);
+				_keyPosition=restartPosition;
 				return;
 			} catch (const Buffer::Error &) {
 				// just continue
@@ -170,9 +199,97 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify)
 	}
 }
 
+// Obsfuscation key runs through the whole image, thus this is only usable for plain images.
+// Context carries over to the next track unless the track resets it. Heavy modes share
+// their tables and last offset through the image as well, so they always go to the same chain
+std::vector<DMSDecompressor::TrackChain> DMSDecompressor::planTrackChains() const
+{
+	constexpr uint32_t noChain{~0U};
+	std::vector<ChainedTrack> tracks;
+	std::vector<uint32_t> trackChains;
+	std::array<bool,80> seenTracks{};
+	uint32_t chainCount{0};
+	uint32_t contextChain{noChain};
+	uint32_t heavyChain{noChain};
+	bool initContext{true};
+	for (uint32_t packedOffset=56,packedChunkLength=0;packedOffset!=_packedSize;packedOffset=OverflowCheck::sum(packedOffset,20U,packedChunkLength))
+	{
+		uint16_t trackNo{_packedData.readBE16(packedOffset+2)};
+		packedChunkLength=_packedData.readBE16(packedOffset+6);
+		if (trackNo==80) break;
+		if (trackNo>=0x8000U) continue;
+		// let the sequential decompression deal with anything weird
+		if (trackNo>80 || seenTracks[trackNo]) return {};
+		seenTracks[trackNo]=true;
+		uint8_t flags{_packedData.read8(packedOffset+12)};
+		uint8_t mode{_packedData.read8(packedOffset+13)};
+
+		uint32_t chain{chainCount};
+		auto join=[&](uint32_t other)
+		{
+			if (other==noChain || other==chain) return;
+			if (chain==chainCount) chain=other;
+				else for (auto &it : trackChains) if (it==other) it=chain;
+		};
+		if (mode>=2U)
+		{
+			if (!initContext) join(contextChain);
+			if (mode>=5U)
+			{
+				join(heavyChain);
+				heavyChain=chain;
+			}
+			contextChain=chain;
+		}
+		if (chain==chainCount) chainCount++;
+		tracks.push_back({packedOffset,initContext});
+		trackChains.push_back(chain);
+
+		if (mode>=2U) initContext=false;
+		if (!(flags&1U)) initContext=true;
+	}
+
+	std::vector<TrackChain> chains(chainCount);
+	for (size_t i=0;i<tracks.size();i++) chains[trackChains[i]].push_back(tracks[i]);
+	chains.erase(std::remove_if(chains.begin(),chains.end(),[](const TrackChain &chain)
+	{
+		return chain.empty();
+	}),chains.end());
+	return chains;
+}
+
+// Returns the first position from startPosition onwards where the first track decompresses
+// correctly, or 0x20000 if there is none. Chunks are searched in parallel
+uint32_t DMSDecompressor::findKeyPosition(uint32_t startPosition) const
+{
+	constexpr uint32_t endPosition{0x20000U};
+	constexpr uint32_t chunkSize{0x1000U};
+	if (startPosition>=endPosition) return endPosition;
+	std::atomic<uint32_t> found{endPosition};
+	Parallel::forEach((endPosition-startPosition+chunkSize-1U)/chunkSize,[&](size_t i)
+	{
+		uint32_t position{startPosition+uint32_t(i)*chunkSize};
+		if (position>found) return;
+		MemoryBuffer rawData{_rawSize};
+		KeySearch keySearch{std::min(position+chunkSize,endPosition),found};
+		try
+		{
+			decompressImpl(rawData,false,position,nullptr,&keySearch);
+		} catch (const Buffer::Error &) {
+			return;
+		} catch (const Decompressor::Error &) {
+			return;
+		}
+		// keep the earliest one
+		uint32_t current{found};
+		while (position<current && !found.compare_exchange_weak(current,position));
+	});
+	return found;
+}
+
 // TODO: Too much state for a single method. too convoluted
 // needs to be split
-void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &restartPosition)
+void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &restartPosition,const TrackChain *chain,const KeySearch *keySearch) const
 {
 	if (rawData.size()<_rawSize)
 		throw DecompressionError();
@@ -250,8 +367,8 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &resta
 		outputStream.reset(start,OverflowCheck::sum(start,length));
 	};
 
-	// fill unused tracks with zeros
-	std::memset(rawData.data(),0,_rawSize);
+	// fill unused tracks with zeros. already done when decompressing chains
+	if (!chain) std::memset(rawData.data(),0,_rawSize);
 
 	bool doInitContext{true};
 	// quick: context used is 256 bytes
@@ -476,11 +593,19 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &resta
 
 	bool _codeFixed{false};
 	uint32_t trackLength=(_isHD)?22528:11264;
+	size_t chainIndex{0};
 	for (uint32_t packedOffset=56,packedChunkLength=0;packedOffset!=_packedSize;packedOffset=OverflowCheck::sum(packedOffset,20U,packedChunkLength))
 	{
 		// There are some info tracks, at -1 or 80. ignore those (if still present)
 		uint16_t trackNo{_packedData.readBE16(packedOffset+2)};
 		packedChunkLength=_packedData.readBE16(packedOffset+6);
+		if (chain)
+		{
+			// skip tracks of other chains, context state comes from the plan
+			if (chainIndex==chain->size()) break;
+			if ((*chain)[chainIndex].packedOffset!=packedOffset) continue;
+			doInitContext=(*chain)[chainIndex++].initContext;
+		}
 		if (trackNo==80) break;							// should not happen, this is already excluded
 		// even though only -1 should be used I've seen -2 as well. ignore all negatives
 		uint32_t tmpChunkLength{_packedData.readBE16(packedOffset+8)};		// after the first unpack (if twostage)
@@ -578,9 +703,17 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &resta
 		{
 			if (!_isObsfuscated || trackNo!=_minTrack || _codeFixed) return processBlock(doRLE,func,params...);
 
+			// when searching in parallel, stop as soon as an earlier candidate has been found
+			uint32_t searchEnd{keySearch?keySearch->end:0x20000U};
+			auto isCancelled=[&]()->bool
+			{
+				return keySearch && restartPosition>keySearch->found;
+			};
+
 			// fast try
-			if (!trackNo && restartPosition<0x10000U) for (;restartPosition<0x10000U;restartPosition++)
+			if (!trackNo) for (;restartPosition<std::min(searchEnd,0x10000U);restartPosition++)
 			{
+				if (isCancelled()) break;
 				try
 				{
 					doInitContext=true;
@@ -606,8 +739,9 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &resta
 
 			// slow round
 			limitedDecompress=~0U;
-			for (;restartPosition<0x20000U;restartPosition++)
+			for (;restartPosition<searchEnd;restartPosition++)
 			{
+				if (isCancelled()) break;
 				try
 				{
 					doInitContext=true;
@@ -665,6 +799,8 @@ void DMSDecompressor::decompressImpl(Buffer &rawData,bool verify,uint32_t &resta
 			default:
 			throw DecompressionError();
 		}
+		// the key is known after the first track
+		if (keySearch) return;
 		if (!(flags&1)) doInitContext=true;
 
 		if (verify && checksum(rawData,dataOffset-_rawOffset,rawChunkLength)!=_packedData.readBE16(packedOffset+14))
@@ -3,6 +3,9 @@
 #ifndef DMSDECOMPRESSOR_HPP
 #define DMSDECOMPRESSOR_HPP
 
+#include <atomic>
+#include <vector>
+
 #include "Decompressor.hpp"
 
 namespace ancient::internal
@@ -28,7 +31,24 @@ public:
 	static std::shared_ptr<Decompressor> create(const Buffer &packedData,bool exactSizeKnown,bool verify);
 
 private:
-	void decompressImpl(Buffer &rawData,bool verify,uint32_t &restartPosition);
+	struct ChainedTrack
+	{
+		uint32_t	packedOffset;
+		bool		initContext;
+	};
+	// tracks that share decompression state and must be decompressed in order
+	using TrackChain=std::vector<ChainedTrack>;
+
+	// decompresses only the first track, trying keys below end
+	struct KeySearch
+	{
+		uint32_t			end;
+		const std::atomic<uint32_t>	&found;
+	};
+
+	std::vector<TrackChain> planTrackChains() const;
+	uint32_t findKeyPosition(uint32_t startPosition) const;
+	void decompressImpl(Buffer &rawData,bool verify,uint32_t &restartPosition,const TrackChain *chain,const KeySearch *keySearch) const;
 
 	const Buffer	&_packedData;
 
@@ -41,6 +61,7 @@ private:
 	uint32_t	_minTrack;
 	bool		_isHD;
 	bool		_isObsfuscated;
+	uint32_t	_keyPosition{~0U};		// cached from previous decompress
 };
 
 }
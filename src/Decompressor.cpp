@@ -2,6 +2,7 @@
 
 #include "Decompressor.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -27,69 +28,181 @@
 #include "TPWMDecompressor.hpp"
 #include "VicXDecompressor.hpp"
 #include "XPKMain.hpp"
+#include "common/Common.hpp"
+#include "common/WrappedVectorBuffer.hpp"
 
 namespace ancient::internal
 {
 
 // ---
 
-static std::vector<std::pair<bool(*)(uint32_t,uint32_t),std::shared_ptr<Decompressor>(*)(const Buffer&,bool,bool)>> decompressors={
-	{BZIP2Decompressor::detectHeader,BZIP2Decompressor::create},
-	{CompactDecompressor::detectHeader,CompactDecompressor::create},
-	{CompressDecompressor::detectHeader,CompressDecompressor::create},
-	{CRMDecompressor::detectHeader,CRMDecompressor::create},
-	{DEFLATEDecompressor::detectHeader,DEFLATEDecompressor::create},
-	{DMSDecompressor::detectHeader,DMSDecompressor::create},
-	{FreezeDecompressor::detectHeader,FreezeDecompressor::create},
-	{IceDecompressor::detectHeader,IceDecompressor::create},
-	{IMPDecompressor::detectHeader,IMPDecompressor::create},
-	{JAMPackerDecompressor::detectHeader,JAMPackerDecompressor::create},
-	{LOBDecompressor::detectHeader,LOBDecompressor::create},
-	{MMCMPDecompressor::detectHeader,MMCMPDecompressor::create},
-	{PackDecompressor::detectHeader,PackDecompressor::create},
-	{PMCDecompressor::detectHeader,PMCDecompressor::create},
-	{PPDecompressor::detectHeader,PPDecompressor::create},
-	{RNCDecompressor::detectHeader,RNCDecompressor::create},
-	{SCOCompressDecompressor::detectHeader,SCOCompressDecompressor::create},
-	{TPWMDecompressor::detectHeader,TPWMDecompressor::create},
-	{VicXDecompressor::detectHeader,VicXDecompressor::create},
-	{XPKMain::detectHeader,XPKMain::create},
+struct DecompressorEntry
+{
+	bool(*detect)(uint32_t,uint32_t);
+	std::shared_ptr<Decompressor>(*create)(const Buffer&,bool,bool);
+	// high 16 bits of the header any of the signatures can have. empty for the fallback tier
+	std::vector<uint16_t> prefixes;
+	// detected from the footer as well, thus tried with any header at its place on the list
+	bool hasFooter{false};
+};
+
+// Decompressors are tried in the order of the list, skipping the ones that can not match the header
+// by their prefixes. Ones with a footer are tried with any header
+static const std::vector<DecompressorEntry> decompressors={
+	{BZIP2Decompressor::detectHeader,BZIP2Decompressor::create,{MultiChar2("BZ")}},
+	{CompactDecompressor::detectHeader,CompactDecompressor::create,{0xff1fU}},
+	{CompressDecompressor::detectHeader,CompressDecompressor::create,{0x1f9dU}},
+	{CRMDecompressor::detectHeader,CRMDecompressor::create,{MultiChar2("Cr"),0x1805U,MultiChar2("CD"),MultiChar2("DC"),MultiChar2("Ir"),MultiChar2("MS"),MultiChar2("ms")}},
+	{DEFLATEDecompressor::detectHeader,DEFLATEDecompressor::create,{0x1f8bU,0x1fa1U}},
+	{DMSDecompressor::detectHeader,DMSDecompressor::create,{MultiChar2("DM")}},
+	{FreezeDecompressor::detectHeader,FreezeDecompressor::create,{0x1f9eU,0x1f9fU}},
+	// Ice 0 is detected from footer
+	{IceDecompressor::detectHeader,IceDecompressor::create,{MultiChar2("Ic"),MultiChar2("TM"),MultiChar2("TS"),MultiChar2("SH"),MultiChar2("IC")},true},
+	{IMPDecompressor::detectHeader,IMPDecompressor::create,{MultiChar2("AT"),MultiChar2("ED"),MultiChar2("IM"),MultiChar2("M."),MultiChar2("BD"),MultiChar2("CH"),MultiChar2("RD"),MultiChar2("Du"),MultiChar2("FL"),MultiChar2("PA")}},
+	{JAMPackerDecompressor::detectHeader,JAMPackerDecompressor::create,{MultiChar2("LS"),MultiChar2("LZ")}},
+	{LOBDecompressor::detectHeader,LOBDecompressor::create,{MultiChar2("\001L"),MultiChar2("\002L"),MultiChar2("\003L")}},
+	{MMCMPDecompressor::detectHeader,MMCMPDecompressor::create,{MultiChar2("zi")}},
+	{PackDecompressor::detectHeader,PackDecompressor::create,{0x1f1eU,0x1f1fU}},
+	{PMCDecompressor::detectHeader,PMCDecompressor::create,{MultiChar2("SF")}},
+	{PPDecompressor::detectHeader,PPDecompressor::create,{MultiChar2("PP"),MultiChar2("PX"),MultiChar2("CH"),MultiChar2("DE"),MultiChar2("DX"),MultiChar2("H."),MultiChar2("RV")}},
+	{RNCDecompressor::detectHeader,RNCDecompressor::create,{MultiChar2("RN"),MultiChar2("..")}},
+	{SCOCompressDecompressor::detectHeader,SCOCompressDecompressor::create,{0x1fa0U}},
+	{StoneCrackerDecompressor::detectSignatureHeader,StoneCrackerDecompressor::create,{MultiChar2("S3"),MultiChar2("S4"),MultiChar2("1A"),MultiChar2("2A"),MultiChar2("Z&"),MultiChar2("ZU"),MultiChar2("AY")}},
+	{TPWMDecompressor::detectHeader,TPWMDecompressor::create,{MultiChar2("TP")}},
+	{VicXDecompressor::detectHeader,VicXDecompressor::create,{MultiChar2("Vi")}},
+	{XPKMain::detectHeader,XPKMain::create,{MultiChar2("XP")}},
 	// Formats with missing id / uncertain detection
 	// old stonecracker is far from certain
-	{StoneCrackerDecompressor::detectHeader,StoneCrackerDecompressor::create},
-	{ByteKillerDecompressor::detectHeader,ByteKillerDecompressor::create}
+	{StoneCrackerDecompressor::detectGuessedHeader,StoneCrackerDecompressor::create,{}},
+	{ByteKillerDecompressor::detectHeader,ByteKillerDecompressor::create,{}}
 	};
 
-std::shared_ptr<Decompressor> Decompressor::create(const Buffer &packedData,bool exactSizeKnown,bool verify)
+// Calls func for the decompressors that could match the header, in the order of the list above
+// and the fallback tier last. func returns true to stop
+template<typename F>
+static void forEachCandidate(uint32_t hdr,bool includeFallbacks,F func)
+{
+	// (prefix, index) sorted. Formats with a footer are kept separately since they match any header
+	static const std::vector<std::pair<uint16_t,uint32_t>> index=[]()
+	{
+		std::vector<std::pair<uint16_t,uint32_t>> ret;
+		for (uint32_t i=0;i<decompressors.size();i++)
+			for (auto prefix : decompressors[i].prefixes)
+				if (!decompressors[i].hasFooter) ret.emplace_back(prefix,i);
+		std::sort(ret.begin(),ret.end());
+		return ret;
+	}();
+	static const std::vector<uint32_t> footers=[]()
+	{
+		std::vector<uint32_t> ret;
+		for (uint32_t i=0;i<decompressors.size();i++)
+			if (decompressors[i].hasFooter) ret.push_back(i);
+		return ret;
+	}();
+	static const std::vector<uint32_t> fallbacks=[]()
+	{
+		std::vector<uint32_t> ret;
+		for (uint32_t i=0;i<decompressors.size();i++)
+			if (decompressors[i].prefixes.empty() && !decompressors[i].hasFooter) ret.push_back(i);
+		return ret;
+	}();
+
+	// merge of the two, both are in the list order
+	uint16_t prefix{uint16_t(hdr>>16U)};
+	auto it{std::lower_bound(index.begin(),index.end(),std::make_pair(prefix,uint32_t(0)))};
+	auto footerIt{footers.begin()};
+	for (;;)
+	{
+		bool hasPrefix{it!=index.end() && it->first==prefix};
+		if (!hasPrefix && footerIt==footers.end()) break;
+		if (hasPrefix && (footerIt==footers.end() || it->second<*footerIt))
+		{
+			if (func(decompressors[it->second])) return;
+			it++;
+		} else {
+			if (func(decompressors[*footerIt])) return;
+			footerIt++;
+		}
+	}
+	if (includeFallbacks)
+		for (auto i : fallbacks)
+			if (func(decompressors[i])) return;
+}
+
+// header and footer as given to the detectors
+static uint32_t readHeader(const Buffer &packedData)
+{
+	return (packedData.size()>=4)?packedData.readBE32(0):(uint32_t(packedData.readBE16(0))<<16);
+}
+
+static uint32_t readFooter(const Buffer &packedData,bool exactSizeKnown)
+{
+	return (exactSizeKnown&&packedData.size()>=4)?packedData.readBE32(packedData.size()-4):0;
+}
+
+static std::shared_ptr<Decompressor> createCandidate(const Buffer &packedData,bool exactSizeKnown,bool verify,bool includeFallbacks)
 {
 	try
 	{
-		uint32_t hdr{(packedData.size()>=4)?packedData.readBE32(0):(uint32_t(packedData.readBE16(0))<<16)};
-		uint32_t footer{(exactSizeKnown&&packedData.size()>=4)?packedData.readBE32(packedData.size()-4):0};
-		for (auto &it : decompressors)
+		uint32_t hdr{readHeader(packedData)};
+		uint32_t footer{readFooter(packedData,exactSizeKnown)};
+		std::shared_ptr<Decompressor> ret;
+		forEachCandidate(hdr,includeFallbacks,[&](const DecompressorEntry &entry)->bool
 		{
 			try
 			{
-				if (it.first(hdr,footer)) return it.second(packedData,exactSizeKnown,verify);
-			} catch (const Error&) {
+				if (entry.detect(hdr,footer)) ret=entry.create(packedData,exactSizeKnown,verify);
+			} catch (const Decompressor::Error&) {
 				// try next on the list
 			}
-		}
-		throw InvalidFormatError();
+			return bool(ret);
+		});
+		if (!ret)
+			throw Decompressor::InvalidFormatError();
+		return ret;
 	} catch (const Buffer::Error&) {
-		throw InvalidFormatError();
+		throw Decompressor::InvalidFormatError();
 	}
 }
 
+std::shared_ptr<Decompressor> Decompressor::create(const Buffer &packedData,bool exactSizeKnown,bool verify)
+{
+	return createCandidate(packedData,exactSizeKnown,verify,true);
+}
+
+std::shared_ptr<Decompressor> Decompressor::createFromSignature(const Buffer &packedData,bool exactSizeKnown,bool verify)
+{
+	return createCandidate(packedData,exactSizeKnown,verify,false);
+}
+
+std::vector<uint16_t> Decompressor::getSignaturePrefixes()
+{
+	std::vector<uint16_t> ret;
+	for (auto &it : decompressors)
+		ret.insert(ret.end(),it.prefixes.begin(),it.prefixes.end());
+	return ret;
+}
+
 bool Decompressor::detect(const Buffer &packedData,bool exactSizeKnown) noexcept
 {
 	if (packedData.size()<2) return false;
-	// need to create the decompressor in order to work with bad detectors.
 	try
 	{
+		// header signature is enough for the primary ones. Footers are checked by creating below
+		uint32_t hdr{readHeader(packedData)};
+		bool found{false};
+		forEachCandidate(hdr,false,[&](const DecompressorEntry &entry)->bool
+		{
+			found=entry.detect(hdr,0);
+			return found;
+		});
+		if (found) return true;
+		// need to create the decompressor in order to work with bad detectors.
 		return bool(create(packedData,exactSizeKnown,true));
 	} catch (const Error&) {
 		return false;
+	} catch (const Buffer::Error&) {
+		return false;
 	}
 }
 
@@ -105,6 +218,24 @@ void Decompressor::decompress(Buffer &rawData,bool verify)
 	}
 }
 
+void Decompressor::decompress(const OutputSink &sink,bool verify)
+{
+	try
+	{
+		decompressStreamImpl(sink,verify);
+	} catch (const Buffer::Error&) {
+		throw DecompressionError();
+	}
+}
+
+void Decompressor::decompressStreamImpl(const OutputSink &sink,bool verify)
+{
+	std::vector<uint8_t> data(getRawSize());
+	WrappedVectorBuffer rawData{data};
+	decompressImpl(rawData,verify);
+	if (rawData.size()) sink(rawData);
+}
+
 size_t Decompressor::getImageSize() const noexcept
 {
 	return 0;
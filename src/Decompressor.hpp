@@ -6,8 +6,10 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common/Buffer.hpp"
 #include "ancient.hpp"
@@ -27,6 +29,12 @@ public:
 	using DecompressionError = ancient::DecompressionError;
 	using VerificationError = ancient::VerificationError;
 
+	// receives consecutive pieces of the raw data in streaming decompression
+	using OutputSink = std::function<void(const Buffer&)>;
+
+	// progress of a key search, returning false stops the search
+	using KeySearchProgress = std::function<bool(size_t done,size_t total)>;
+
 	Decompressor(const Decompressor&)=delete;
 	Decompressor& operator=(const Decompressor&)=delete;
 
@@ -51,6 +59,20 @@ public:
 	// can throw VerificationError if verify enabled and checksum does not match
 	void decompress(Buffer &rawData,bool verify);
 
+	// Hint of the raw size for formats that do not know it before decompressing.
+	// The output is allocated accordingly, it does not need to be exact
+	void setRawSizeHint(size_t rawSizeHint) noexcept { _rawSizeHint=rawSizeHint; }
+
+	// Limits for formats that need to search for the key of obsfuscated data.
+	// maxIterations of 0 means no limit
+	void setKeySearchBudget(size_t maxIterations) noexcept { _keySearchBudget=maxIterations; }
+	void setKeySearchProgress(const KeySearchProgress &progress) { _keySearchProgress=progress; }
+
+	// Streaming decompression. Raw data is given to the sink as it is produced.
+	// Formats with bounded history only keep their history in memory,
+	// others decompress the whole data first and give it to the sink in one piece
+	void decompress(const OutputSink &sink,bool verify);
+
 	// in case of disk image based formats the data does not necessarily start
 	// from logical beginning of the image but it is offsetted inside the logical image
 	// (f.e. DMS). getDataOffset will return the offset (or 0 if not relevant or if offset does not exist)
@@ -73,12 +95,30 @@ public:
 	// can throw VerificationError if verify enabled and checksum does not match
 	static std::shared_ptr<Decompressor> create(const Buffer &packedData,bool exactSizeKnown,bool verify);
 
+	// Same as create, but only the formats having a proper signature are tried
+	static std::shared_ptr<Decompressor> createFromSignature(const Buffer &packedData,bool exactSizeKnown,bool verify);
+
+	// Possible first 2 bytes (big endian) of the signatures. Formats without a signature are not included
+	static std::vector<uint16_t> getSignaturePrefixes();
+
 	// Detect signature whether it matches to any known compressor
 	// This does not guarantee the data is decompressable though, only signature(s) is read
 	static bool detect(const Buffer &packedData,bool exactSizeKnown) noexcept;
 
 protected:
 	virtual void decompressImpl(Buffer &rawData,bool verify)=0;
+	virtual void decompressStreamImpl(const OutputSink &sink,bool verify);
+
+	// hint from the caller if there is one, otherwise the format specific estimate
+	size_t getRawSizeHint(size_t estimate) const noexcept { return _rawSizeHint?_rawSizeHint:estimate; }
+
+	size_t getKeySearchBudget() const noexcept { return _keySearchBudget; }
+	const KeySearchProgress &getKeySearchProgress() const noexcept { return _keySearchProgress; }
+
+private:
+	size_t			_rawSizeHint{0};
+	size_t			_keySearchBudget{0};
+	KeySearchProgress	_keySearchProgress;
 };
 
 }
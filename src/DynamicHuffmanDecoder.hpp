@@ -7,6 +7,7 @@
 #include <cstdint>
 
 #include <array>
+#include <vector>
 
 // For exception
 #include "Decompressor.hpp"
@@ -52,6 +53,7 @@ public:
 			_nodes[i].rightLeaf=r;
 			_codeMap[i]=i;
 		}
+		_lookupDirty=true;
 	}
 
 	template<typename F>
@@ -66,9 +68,50 @@ public:
 		return code;
 	}
 
-	void update(uint32_t code)
+	// Table driven decode, peekBits/consumeBits as in HuffmanDecoder.
+	// Without lookup table this is bit-by-bit decode
+	template<typename F,typename G>
+	uint32_t decode(F peekBits,G consumeBits)
 	{
+		if (!_count)
+			throw Decompressor::DecompressionError();
+		if (_count==1) return 0;
+		uint32_t code{maxCount*2-2};
+		if (_lookupBits)
+		{
+			if (_lookupDirty)
+			{
+				fillLookup(code,0,0);
+				_lookupDirty=false;
+			}
+			const LookupEntry &entry{_lookup[peekBits(_lookupBits)]};
+			consumeBits(entry.length);
+			code=entry.node;
+		}
+		while (code>=maxCount)
+		{
+			code=peekBits(1U)?_nodes[code].rightLeaf:_nodes[code].leftLeaf;
+			consumeBits(1U);
+		}
+		return code;
+	}
+
+	// Creates lookup table for the top maxBits levels of the tree.
+	// Unlike in HuffmanDecoder, the table is kept in sync by update/halve/reset/addCode:
+	// Only swaps touching the top levels patch it, everything else rebuilds it on next decode.
+	// lsbFirst as in HuffmanDecoder
+	void createLookupTable(uint32_t maxBits,bool lsbFirst)
+	{
+		if (!maxBits || maxBits>16U)
+			throw Decompressor::DecompressionError();
+		_lookup.resize(size_t(1U)<<maxBits);
+		_lookupBits=maxBits;
+		_lookupLSBFirst=lsbFirst;
+		_lookupDirty=true;
+	}
 
+	void update(uint32_t code)
+	{
 		if (code>=_count)
 			throw Decompressor::DecompressionError();
 		// this is a bug in LH2. Nobody else uses this codepath, so we can let it be...
@@ -80,14 +123,18 @@ public:
 
 		while (code!=maxCount*2-2)
 		{
-			_nodes[code].frequency++;
-
+			uint32_t freq{++_nodes[code].frequency};
 			uint32_t index{_nodes[code].index};
-			uint32_t destIndex{index};
-			uint32_t freq{_nodes[code].frequency};
 
+			// Common case: Order does not change, continue with the parent
+			if (freq<=_nodes[_codeMap[index+1]].frequency)
+			{
+				code=_nodes[code].parent;
+				continue;
+			}
+
+			uint32_t destIndex{index+1};
 			while (destIndex!=maxCount*2-2 && freq>_nodes[_codeMap[destIndex+1]].frequency) destIndex++;
-			if (index!=destIndex)
 			{
 				auto getParentLeaf=[&](uint32_t currentCode)->uint32_t&
 				{
@@ -100,6 +147,11 @@ public:
 				std::swap(_codeMap[index],_codeMap[destIndex]);
 				std::swap(getParentLeaf(code),getParentLeaf(destCode));
 				std::swap(_nodes[code].parent,_nodes[destCode].parent);
+				if (_lookupBits && !_lookupDirty)
+				{
+					updateLookup(code);
+					updateLookup(destCode);
+				}
 			}
 			code=_nodes[code].parent;
 		}
@@ -146,6 +198,7 @@ public:
 				std::swap(code,destCode);
 			}	
 		}
+		_lookupDirty=true;
 	}
 
 	// Defined as in LH2
@@ -202,6 +255,7 @@ public:
 				std::swap(parent.leftLeaf,parent.rightLeaf);
 			_count++;
 		}
+		_lookupDirty=true;
 	}
 
 	uint32_t getMaxFrequency() const noexcept
@@ -210,6 +264,40 @@ public:
 	}
 
 private:
+	// fills the lookup for the subtree of node at given depth and path (first bit highest)
+	void fillLookup(uint32_t node,uint32_t depth,uint32_t path)
+	{
+		if (node>=maxCount && depth<_lookupBits)
+		{
+			fillLookup(_nodes[node].leftLeaf,depth+1U,path<<1U);
+			fillLookup(_nodes[node].rightLeaf,depth+1U,(path<<1U)|1U);
+			return;
+		}
+		uint32_t fillLength{_lookupBits-depth};
+		uint32_t code{path};
+		if (_lookupLSBFirst)
+		{
+			code=0;
+			for (uint32_t i=0;i<depth;i++)
+				code|=((path>>i)&1U)<<(depth-i-1U);
+		}
+		for (uint32_t i=0;i<(1U<<fillLength);i++)
+			_lookup[_lookupLSBFirst?(code|(i<<depth)):((code<<fillLength)|i)]=LookupEntry{node,depth};
+	}
+
+	// node has moved, refill its new location if it is within the lookup
+	void updateLookup(uint32_t node)
+	{
+		uint32_t depth{0};
+		uint32_t path{0};
+		for (uint32_t code=node;code!=maxCount*2-2;code=_nodes[code].parent,depth++)
+		{
+			if (depth==_lookupBits) return;
+			path|=(_nodes[_nodes[code].parent].rightLeaf==code?1U:0)<<depth;
+		}
+		fillLookup(node,depth,path);
+	}
+
 	struct Node
 	{
 		uint32_t	frequency;
@@ -219,10 +307,21 @@ private:
 		uint32_t	rightLeaf;
 	};
 
+	struct LookupEntry
+	{
+		uint32_t	node;
+		uint32_t	length;
+	};
+
 	uint32_t		_initialCount;
 	uint32_t		_count;
 	std::array<Node,maxCount*2-1> _nodes;
 	std::array<uint32_t,maxCount*2-1> _codeMap;
+
+	std::vector<LookupEntry>	_lookup;
+	uint32_t			_lookupBits{0};
+	bool				_lookupLSBFirst{false};
+	bool				_lookupDirty{true};
 };
 
 }
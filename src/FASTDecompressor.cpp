@@ -33,6 +33,11 @@ const std::string &FASTDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool FASTDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void FASTDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream forwardInputStream{_packedData,0,_packedData.size()};
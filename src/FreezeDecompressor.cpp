@@ -6,6 +6,7 @@
 #include "InputStream.hpp"
 #include "OutputStream.hpp"
 #include "common/Common.hpp"
+#include "common/WrappedVectorBuffer.hpp"
 
 
 namespace ancient::internal
@@ -79,6 +80,18 @@ size_t FreezeDecompressor::getRawSize() const noexcept
 }
 
 void FreezeDecompressor::decompressImpl(Buffer &rawData,bool verify)
+{
+	decompressInternal(rawData,nullptr,verify);
+}
+
+void FreezeDecompressor::decompressStreamImpl(const OutputSink &sink,bool verify)
+{
+	std::vector<uint8_t> data;
+	WrappedVectorBuffer rawData{data};
+	decompressInternal(rawData,&sink,verify);
+}
+
+void FreezeDecompressor::decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify)
 {
 	ForwardInputStream inputStream(_packedData,_isOldVersion?2U:5U,_packedSize?_packedSize:_packedData.size());
 
@@ -91,18 +104,24 @@ void FreezeDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		_packedSize=inputStream.getOffset();
 	}
 
-	MSBBitReader<ForwardInputStream> bitReader{inputStream};
+	MSBBitReader64<ForwardInputStream> bitReader{inputStream};
 	auto readBits=[&](uint32_t count)->uint32_t
 	{
-		return bitReader.readBits8(count);
+		return bitReader.readBits(count);
+	};
+	auto peekBits=[&](uint32_t count)->uint32_t
+	{
+		return bitReader.peekBits(count);
 	};
-	auto readBit=[&]()->uint32_t
+	auto consumeBits=[&](uint32_t count)
 	{
-		return bitReader.readBits8(1);
+		bitReader.consumeBits(count);
 	};
 
-	AutoExpandingForwardOutputStream outputStream{rawData};
+	// LZ with small window. Typically 2:1 or more
+	AutoExpandingForwardOutputStream outputStream{rawData,sink,8192U,getRawSizeHint(_exactSizeKnown?_packedData.size()*2U:0)};
 	DynamicHuffmanDecoder<511U> decoder{_isOldVersion?315U:511U};
+	decoder.createLookupTable(8U,false);
 	HuffmanDecoder<uint8_t> distanceDecoder;
 	{
 		std::array<uint8_t,64> distanceHighBits;
@@ -115,12 +134,13 @@ void FreezeDecompressor::decompressImpl(Buffer &rawData,bool verify)
 				distanceHighBits[j++]=i+1U;
 		}
 		distanceDecoder.createOrderlyHuffmanTable(distanceHighBits,j);
+		distanceDecoder.createLookupTable(8U,false);
 	}
 
 	uint32_t distanceBits{_isOldVersion?6U:7U};
 	for(;;)
 	{
-		uint32_t code{decoder.decode(readBit)};
+		uint32_t code{decoder.decode(peekBits,consumeBits)};
 		if (decoder.getMaxFrequency()==0x8000U) decoder.halve();
 		decoder.update(code);
 		if (code==256U) break;
@@ -128,13 +148,15 @@ void FreezeDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		{
 			outputStream.writeByte(code);
 		} else {
-			uint32_t distance{uint32_t(distanceDecoder.decode(readBit)<<distanceBits)};
+			uint32_t distance{uint32_t(distanceDecoder.decode(peekBits,consumeBits)<<distanceBits)};
 			distance|=readBits(distanceBits);
 			distance++;
 			uint32_t count{code-254U};
 			outputStream.copy(distance,count,0x20);
 		}
 	}
+	outputStream.flush();
+	bitReader.reset();
 	_rawSize=outputStream.getOffset();
 	if (_exactSizeKnown && inputStream.getOffset()!=_packedSize)
 		throw DecompressionError();
@@ -22,12 +22,15 @@ public:
 	const std::string &getName() const noexcept final;
 
 	void decompressImpl(Buffer &rawData,bool verify) final;
+	void decompressStreamImpl(const OutputSink &sink,bool verify) final;
 
 	static bool detectHeader(uint32_t hdr,uint32_t footer) noexcept;
 
 	static std::shared_ptr<Decompressor> create(const Buffer &packedData,bool exactSizeKnown,bool verify);
 
 private:
+	void decompressInternal(Buffer &rawData,const OutputSink *sink,bool verify);
+
 	const Buffer	&_packedData;
 
 	size_t		_packedSize{0};
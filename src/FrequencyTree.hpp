@@ -14,37 +14,38 @@
 namespace ancient::internal
 {
 
+// Implicit binary tree in heap order: root at 1, children of node i at 2i and 2i+1 and the symbols
+// as leaves starting from _size. Leaves are padded with zeros to power of two, so the decode can
+// descend without bounds checks
 template<typename T,typename U,size_t V>
 class FrequencyTree
 {
 public:
 	FrequencyTree() noexcept
 	{
-		for (uint32_t i=0;i<_size;i++)
+		for (uint32_t i=0;i<_size*2U;i++)
 			_tree[i]=0;
 	}
 	~FrequencyTree() noexcept=default;
 
 	U decode(T value,T &low,T &freq) const
 	{
-		if (value>=_tree[_size-1])
+		if (value>=_tree[1])
 			throw Decompressor::DecompressionError();
-		U symbol{0};
+		uint32_t node{1};
 		low=0;
-		for (uint32_t i=_levels-2;;i--)
+		for (uint32_t i=1;i<_levels;i++)
 		{
-			T tmp{_tree[_levelOffsets[i]+symbol]};
-			if (uint32_t(symbol+1)<_levelSizes[i] && value>=tmp)
-			{
-				symbol++;
-				low+=tmp;
-				value-=tmp;
-			}
-			if (!i) break;
-			symbol<<=1;
+			// branchless: mask is all ones when going right
+			T tmp{_tree[node<<1]};
+			uint32_t mask{0U-uint32_t(value>=tmp)};
+			tmp=T(tmp&mask);
+			node=(node<<1)+(mask&1U);
+			low+=tmp;
+			value-=tmp;
 		}
-		freq=_tree[symbol];
-		return symbol;
+		freq=_tree[node];
+		return U(node-_size);
 	}
 
 	template <typename F>
@@ -55,7 +56,7 @@ public:
 
 		for (uint32_t symbol=0;symbol<V;)
 		{
-			while (_tree[_levelOffsets[level]+(symbol>>level)])
+			while (_tree[(_size+symbol)>>level])
 			{
 				if (level)
 				{
@@ -84,7 +85,7 @@ public:
 
 		for (uint32_t symbol=0;symbol<V;)
 		{
-			while (_tree[_levelOffsets[level]+(symbol>>level)]!=std::min(step,uint32_t(V)-symbol))
+			while (_tree[(_size+symbol)>>level]!=std::min(step,uint32_t(V)-symbol))
 			{
 				if (level)
 				{
@@ -108,7 +109,7 @@ public:
 	{
 		if (symbol>=V)
 			throw Decompressor::DecompressionError();
-		return _tree[symbol];
+		return _tree[_size+symbol];
 	}
 	
 	void add(U symbol,typename std::make_signed<T>::type freq)
@@ -116,10 +117,11 @@ public:
 		if (symbol>=V)
 			throw Decompressor::DecompressionError();
 		if (!freq) return;
+		uint32_t node{_size+symbol};
 		for (uint32_t i=0;i<_levels;i++)
 		{
-			_tree[_levelOffsets[i]+symbol]+=freq;
-			symbol>>=1;
+			_tree[node]+=freq;
+			node>>=1;
 		}
 	}
 
@@ -128,71 +130,34 @@ public:
 		if (symbol>=V)
 			throw Decompressor::DecompressionError();
 		// TODO: check behavior on large numbers
-		typename std::make_signed<T>::type delta=freq-_tree[symbol];
+		typename std::make_signed<T>::type delta=freq-_tree[_size+symbol];
 		add(symbol,delta);
 	}
 
 	T getTotal() const noexcept
 	{
-		return _tree[_size-1];
+		return _tree[1];
 	}
 
 private:
-	static constexpr uint32_t levelSize(uint32_t level)
-	{
-		uint32_t ret=V;
-		for (uint32_t i=0;i<level;i++)
-			ret=(ret+1)>>1;
-		return ret;
-	}
-
-	static constexpr uint32_t levels()
-	{
-		uint32_t ret{0};
-		while (levelSize(ret)!=1) ret++;
-		return ret+1;
-	}
-
 	static constexpr uint32_t size()
 	{
-		uint32_t ret{0};
-		for (uint32_t i=0;i<levels();i++)
-			ret+=levelSize(i);
+		uint32_t ret{1};
+		while (ret<V) ret<<=1;
 		return ret;
 	}
 
-	static constexpr uint32_t levelOffset(uint32_t level)
+	static constexpr uint32_t levels()
 	{
-		uint32_t ret{0};
-		for (uint32_t i=0;i<level;i++)
-			ret+=levelSize(i);
+		uint32_t ret{1};
+		while ((1U<<(ret-1))<V) ret++;
 		return ret;
 	}
 
-	template<uint32_t... I>
-	static constexpr auto makeLevelOffsetSequence(std::integer_sequence<uint32_t,I...>)
-	{
-		return std::integer_sequence<uint32_t,levelOffset(I)...>{};
-	}
-
-	template<uint32_t... I>
-	static constexpr auto makeLevelSizeSequence(std::integer_sequence<uint32_t,I...>)
-	{
-		return std::integer_sequence<uint32_t,levelSize(I)...>{};
-	}
- 	
-	template<uint32_t... I>
-	static constexpr std::array<uint32_t,sizeof...(I)> makeArray(std::integer_sequence<uint32_t,I...>)
-	{
-		return std::array<uint32_t,sizeof...(I)>{{I...}};
-	}
-
-	static constexpr uint32_t			_size{size()};
-	static constexpr uint32_t			_levels{levels()};
-	static constexpr std::array<uint32_t,_levels>	_levelOffsets{makeArray(makeLevelOffsetSequence(std::make_integer_sequence<uint32_t,levels()>{}))};
-	static constexpr std::array<uint32_t,_levels>	_levelSizes{makeArray(makeLevelSizeSequence(std::make_integer_sequence<uint32_t,levels()>{}))};
+	static constexpr uint32_t	_size{size()};
+	static constexpr uint32_t	_levels{levels()};
 
-	std::array<T,_size>					_tree;
+	std::array<T,_size*2U>		_tree;
 };
 
 }
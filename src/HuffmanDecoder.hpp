@@ -24,7 +24,7 @@ struct HuffmanCode
 
 	T		value;
 
-	HuffmanCode(uint32_t _length,uint32_t _code,T _value) noexcept :
+	constexpr HuffmanCode(uint32_t _length,uint32_t _code,T _value) noexcept :
 		length{_length},
 		code{_code},
 		value{_value}
@@ -74,6 +74,12 @@ private:
 		}
 	};
 
+	struct LookupEntry
+	{
+		uint32_t	node;
+		uint32_t	length;
+	};
+
 public:
 	HuffmanDecoder() noexcept=default;
 
@@ -91,6 +97,7 @@ public:
 	void reset()
 	{
 		_table.clear();
+		clearLookupTable();
 	}
 
 	template<typename F>
@@ -108,8 +115,93 @@ public:
 		return _table[i].value;
 	}
 
+	// Table driven decode. peekBits(count) returns next count bits without consuming them
+	// (zero-padded past the end of stream), consumeBits(count) skips them.
+	// Works without lookup table as well, but then it is just a slower bit-by-bit decode
+	template<typename F,typename G>
+	const T &decode(F peekBits,G consumeBits) const
+	{
+		if (!_table.size())
+			throw Decompressor::DecompressionError();
+		uint32_t i{0};
+		if (_lookupBits)
+		{
+			const LookupEntry &entry{_lookup[peekBits(_lookupBits)]};
+			if (!entry.length)
+				throw Decompressor::DecompressionError();
+			consumeBits(entry.length);
+			i=entry.node;
+		}
+		// codes longer than the lookup table continue from the tree
+		while (_table[i].left || _table[i].right)
+		{
+			i=peekBits(1U)?_table[i].right:_table[i].left;
+			consumeBits(1U);
+			if (!i)
+				throw Decompressor::DecompressionError();
+		}
+		return _table[i].value;
+	}
+
+	// Creates lookup table for the first maxBits of the codes (or less if the tree is shallower).
+	// Needs to be called after the table is complete, any insert will discard it.
+	// lsbFirst: whether peekBits returns the first bit of the code in the lowest bit (LSBBitReader)
+	// or in the highest bit (MSBBitReader)
+	void createLookupTable(uint32_t maxBits,bool lsbFirst)
+	{
+		clearLookupTable();
+		if (!_table.size() || maxBits>24U)
+			throw Decompressor::DecompressionError();
+
+		// collect leaves and the nodes cut at maxBits depth
+		struct Item
+		{
+			uint32_t	node;
+			uint32_t	depth;
+			uint32_t	code;
+		};
+		std::vector<Item> stack{{0,0,0}};
+		std::vector<Item> items;
+		uint32_t bits{0};
+		while (stack.size())
+		{
+			Item item{stack.back()};
+			stack.pop_back();
+			const Node &node{_table[item.node]};
+			if ((!node.left && !node.right) || item.depth==maxBits)
+			{
+				items.push_back(item);
+				if (item.depth>bits) bits=item.depth;
+			} else {
+				if (node.left) stack.push_back({node.left,item.depth+1,item.code<<1});
+				if (node.right) stack.push_back({node.right,item.depth+1,(item.code<<1)|1U});
+			}
+		}
+		if (!bits) return;
+
+		_lookup.resize(size_t(1U)<<bits,LookupEntry{0,0});
+		for (auto &item : items)
+		{
+			uint32_t fillLength{bits-item.depth};
+			uint32_t code{item.code};
+			if (lsbFirst)
+			{
+				code=0;
+				for (uint32_t j=0;j<item.depth;j++)
+					code|=((item.code>>j)&1U)<<(item.depth-j-1U);
+			}
+			for (uint32_t j=0;j<(1U<<fillLength);j++)
+			{
+				uint32_t index{lsbFirst?(code|(j<<item.depth)):((code<<fillLength)|j)};
+				_lookup[index]=LookupEntry{item.node,item.depth};
+			}
+		}
+		_lookupBits=bits;
+	}
+
 	void insert(const HuffmanCode<T> &code)
 	{
+		clearLookupTable();
 		uint32_t i{0};
 		uint32_t length={uint32_t(_table.size())};
 		for (int32_t currentBit=code.length;currentBit>=0;currentBit--)
@@ -187,7 +279,15 @@ public:
 	}
 
 private:
-	std::vector<Node>	_table;
+	void clearLookupTable() noexcept
+	{
+		_lookup.clear();
+		_lookupBits=0;
+	}
+
+	std::vector<Node>		_table;
+	std::vector<LookupEntry>	_lookup;
+	uint32_t			_lookupBits{0};
 };
 
 template<typename T>
@@ -215,6 +315,13 @@ public:
 			else return _base.decode(bitReader);
 	}
 
+	template<typename F,typename G>
+	T decode(F peekBits,G consumeBits) const
+	{
+		if (!_base._table.size()) return _emptyValue;
+			else return _base.decode(peekBits,consumeBits);
+	}
+
 	void insert(const HuffmanCode<T> &code)
 	{
 		_base.insert(code);
@@ -227,11 +334,162 @@ public:
 		_base.createOrderlyHuffmanTable(bitLengths,bitTableLength);
 	}
 
+	void createLookupTable(uint32_t maxBits,bool lsbFirst)
+	{
+		if (_base._table.size()) _base.createLookupTable(maxBits,lsbFirst);
+	}
+
 private:
 	HuffmanDecoder<T>	_base;
 	T			_emptyValue{0};
 };
 
+// Huffman decoder for fixed code tables, to be built at compile time and shared:
+//   static constexpr StaticHuffmanDecoder<uint8_t,3> decoder{HuffmanCode{...},...};
+// N is the number of codes (or symbols for createOrderly). Same decode interface as HuffmanDecoder,
+// with lookupBits the lookup table for the peekBits/consumeBits decode is built as well
+template<typename T,size_t N,uint32_t lookupBits=0,bool lsbFirst=false>
+class StaticHuffmanDecoder
+{
+public:
+	template<typename ...Args>
+	explicit constexpr StaticHuffmanDecoder(const Args& ...args)
+	{
+		static_assert(sizeof...(args)==N);
+		(insert(args),...);
+		createLookupTable();
+	}
+
+	~StaticHuffmanDecoder() noexcept=default;
+
+	// Canonical codes from the bit lengths as in HuffmanDecoder::createOrderlyHuffmanTable
+	static constexpr StaticHuffmanDecoder createOrderly(const std::array<uint8_t,N> &bitLengths)
+	{
+		StaticHuffmanDecoder ret;
+		uint32_t maxDepth{0};
+		for (uint32_t i=0;i<N;i++)
+			if (bitLengths[i]>maxDepth) maxDepth=bitLengths[i];
+		uint32_t code{0};
+		for (uint32_t depth=1;depth<=maxDepth;depth++)
+		{
+			code<<=1;
+			for (uint32_t i=0;i<N;i++)
+				if (bitLengths[i]==depth) ret.insert(HuffmanCode<T>{depth,code++,T(i)});
+		}
+		ret.createLookupTable();
+		return ret;
+	}
+
+	template<typename F>
+	const T &decode(F bitReader) const
+	{
+		uint32_t i{0};
+		while (_table[i].left || _table[i].right)
+		{
+			i=bitReader()?_table[i].right:_table[i].left;
+			if (!i)
+				throw Decompressor::DecompressionError();
+		}
+		return _table[i].value;
+	}
+
+	template<typename F,typename G>
+	const T &decode(F peekBits,G consumeBits) const
+	{
+		uint32_t i{0};
+		if constexpr (lookupBits!=0)
+		{
+			const LookupEntry &entry{_lookup[peekBits(lookupBits)]};
+			if (!entry.length)
+				throw Decompressor::DecompressionError();
+			consumeBits(entry.length);
+			i=entry.node;
+		}
+		while (_table[i].left || _table[i].right)
+		{
+			i=peekBits(1U)?_table[i].right:_table[i].left;
+			consumeBits(1U);
+			if (!i)
+				throw Decompressor::DecompressionError();
+		}
+		return _table[i].value;
+	}
+
+private:
+	struct Node
+	{
+		uint32_t	left{0};
+		uint32_t	right{0};
+		T		value{};
+	};
+
+	struct LookupEntry
+	{
+		uint32_t	node{0};
+		uint32_t	length{0};
+	};
+
+	constexpr StaticHuffmanDecoder() noexcept=default;
+
+	// as HuffmanDecoder::insert. Incomplete tables might need more nodes than there is space for,
+	// which is a compile error for a constexpr decoder
+	constexpr void insert(const HuffmanCode<T> &code)
+	{
+		uint32_t i{0};
+		uint32_t length{_tableSize};
+		for (int32_t currentBit=code.length;currentBit>=0;currentBit--)
+		{
+			uint32_t codeBit{(currentBit && ((code.code>>(currentBit-1U))&1U))?1U:0};
+			if (i!=length)
+			{
+				if (!currentBit || (!_table[i].left && !_table[i].right))
+					throw Decompressor::DecompressionError();
+				uint32_t &tmp{codeBit?_table[i].right:_table[i].left};
+				if (!tmp) tmp=i=length;
+					else i=tmp;
+			} else {
+				if (length==_table.size())
+					throw Decompressor::DecompressionError();
+				_table[length]=Node{(currentBit&&!codeBit)?length+1:0,(currentBit&&codeBit)?length+1:0,currentBit?T():code.value};
+				length++;
+				i++;
+			}
+		}
+		_tableSize=length;
+	}
+
+	constexpr void createLookupTable()
+	{
+		if constexpr (lookupBits!=0) fillLookup(0,0,0);
+	}
+
+	// code has the first bit highest
+	constexpr void fillLookup(uint32_t node,uint32_t depth,uint32_t code)
+	{
+		const Node &current{_table[node]};
+		if ((current.left || current.right) && depth<lookupBits)
+		{
+			if (current.left) fillLookup(current.left,depth+1U,code<<1U);
+			if (current.right) fillLookup(current.right,depth+1U,(code<<1U)|1U);
+			return;
+		}
+		uint32_t fillLength{lookupBits-depth};
+		uint32_t index{code};
+		if (lsbFirst)
+		{
+			index=0;
+			for (uint32_t i=0;i<depth;i++)
+				index|=((code>>i)&1U)<<(depth-i-1U);
+		}
+		for (uint32_t i=0;i<(1U<<fillLength);i++)
+			_lookup[lsbFirst?(index|(i<<depth)):((index<<fillLength)|i)]=LookupEntry{node,depth};
+	}
+
+	std::array<Node,N*2U>						_table{};
+	uint32_t							_tableSize{0};
+	std::array<LookupEntry,(size_t(1U)<<lookupBits)>		_lookup{};
+};
+
 }
 
 #endif
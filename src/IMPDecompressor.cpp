@@ -122,6 +122,11 @@ const std::string &IMPDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool IMPDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 size_t IMPDecompressor::getPackedSize() const noexcept
 {
 	return _endOffset+0x32;
@@ -227,7 +232,7 @@ void IMPDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		distanceBits[i>>2][i&3]=_packedData.read8(_endOffset+34+i);
 
 	// length, distance & literal counts are all intertwined
-	HuffmanDecoder<uint8_t> lldDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,6> lldDecoder
 	{
 		HuffmanCode{1,0b00000,uint8_t{0}},
 		HuffmanCode{2,0b00010,uint8_t{1}},
@@ -237,7 +242,7 @@ void IMPDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		HuffmanCode{5,0b11111,uint8_t{5}}
 	};
 
-	HuffmanDecoder<uint8_t> lldDecoder2
+	static constexpr StaticHuffmanDecoder<uint8_t,3> lldDecoder2
 	{
 		HuffmanCode{1,0b00,uint8_t{0}},
 		HuffmanCode{2,0b10,uint8_t{1}},
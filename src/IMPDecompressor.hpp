@@ -18,6 +18,7 @@ public:
 
 	const std::string &getName() const noexcept final;
 	const std::string &getSubName() const noexcept final;
+	bool isChunkIndependent() const noexcept final;
 
 	size_t getPackedSize() const noexcept final;
 	size_t getRawSize() const noexcept final;
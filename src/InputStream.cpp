@@ -9,6 +9,7 @@ namespace ancient::internal
 
 ForwardInputStream::ForwardInputStream(const Buffer &buffer,size_t startOffset,size_t endOffset,size_t overrunAllowance) :
 	_buffer{buffer},
+	_data{buffer.data()},
 	_currentOffset{startOffset},
 	_endOffset{endOffset},
 	_overrunAllowance{overrunAllowance}
@@ -23,24 +24,17 @@ void ForwardInputStream::reset(size_t startOffset,size_t endOffset)
 	_endOffset=endOffset;
 	if (_currentOffset>_endOffset || _currentOffset>_buffer.size() || _endOffset>_buffer.size())
 		throw Decompressor::DecompressionError();
+	_data=_buffer.data();
 
 	if (_linkedInputStream) _linkedInputStream->setEndOffset(_currentOffset);
 }
 
-uint8_t ForwardInputStream::readByte()
+uint8_t ForwardInputStream::readOverrun()
 {
-	if (_currentOffset>=_endOffset)
-	{
-		if (_overrunAllowance)
-		{
-			_overrunAllowance--;
-			return 0;
-		}
+	if (!_overrunAllowance)
 		throw Decompressor::DecompressionError();
-	}
-	uint8_t ret{_buffer[_currentOffset++]};
-	if (_linkedInputStream) _linkedInputStream->setEndOffset(_currentOffset);
-	return ret;
+	_overrunAllowance--;
+	return 0;
 }
 
 uint16_t ForwardInputStream::readBE16()
@@ -85,6 +79,16 @@ std::shared_ptr<const Buffer> ForwardInputStream::consume(size_t bytes)
 	return ret;
 }
 
+const uint8_t *ForwardInputStream::readDirect(size_t bytes)
+{
+	if (OverflowCheck::sum(_currentOffset,bytes)>_endOffset)
+		throw Decompressor::DecompressionError();
+	const uint8_t *ret{_data+_currentOffset};
+	_currentOffset+=bytes;
+	if (_linkedInputStream) _linkedInputStream->setEndOffset(_currentOffset);
+	return ret;
+}
+
 void ForwardInputStream::setOffset(size_t offset)
 {
 	if (offset>_endOffset)
@@ -94,7 +98,7 @@ void ForwardInputStream::setOffset(size_t offset)
 }
 
 BackwardInputStream::BackwardInputStream(const Buffer &buffer,size_t startOffset,size_t endOffset) :
-	_buffer{buffer},
+	_data{buffer.data()},
 	_currentOffset{endOffset},
 	_endOffset{startOffset}
 {
@@ -102,15 +106,6 @@ BackwardInputStream::BackwardInputStream(const Buffer &buffer,size_t startOffset
 		throw Decompressor::DecompressionError();
 }
 
-uint8_t BackwardInputStream::readByte()
-{
-	if (_currentOffset<=_endOffset)
-		throw Decompressor::DecompressionError();
-	uint8_t ret=_buffer[--_currentOffset];
-	if (_linkedInputStream) _linkedInputStream->setEndOffset(_currentOffset);
-	return ret;
-}
-
 uint16_t BackwardInputStream::readBE16()
 {
 	uint16_t b0{readByte()};
@@ -35,6 +35,8 @@ public:
 	uint16_t readLE16();
 	uint32_t readLE32();
 	std::shared_ptr<const Buffer> consume(size_t bytes);
+	// bulk access, bounds are checked once for all of the bytes. no overrun allowance
+	const uint8_t *readDirect(size_t bytes);
 
 	bool eof() const noexcept { return _currentOffset==_endOffset; }
 	size_t getOffset() const noexcept { return _currentOffset; }
@@ -46,8 +48,11 @@ public:
 
 private:
 	void setEndOffset(size_t offset) noexcept { _endOffset=offset; }
+	uint8_t readOverrun();
 
 	const Buffer		&_buffer;
+	// cached, the buffer does not change while being read
+	const uint8_t		*_data;
 	size_t			_currentOffset;
 	size_t			_endOffset;
 	size_t			_overrunAllowance;
@@ -79,13 +84,31 @@ public:
 private:
 	void setEndOffset(size_t offset) noexcept { _endOffset=offset; }
 
-	const Buffer		&_buffer;
+	const uint8_t		*_data;
 	size_t			_currentOffset;
 	size_t			_endOffset;
 
 	ForwardInputStream	*_linkedInputStream{nullptr};
 };
 
+inline uint8_t ForwardInputStream::readByte()
+{
+	if (_currentOffset>=_endOffset)
+		return readOverrun();
+	uint8_t ret{_data[_currentOffset++]};
+	if (_linkedInputStream) _linkedInputStream->setEndOffset(_currentOffset);
+	return ret;
+}
+
+inline uint8_t BackwardInputStream::readByte()
+{
+	if (_currentOffset<=_endOffset)
+		throw Decompressor::DecompressionError();
+	uint8_t ret{_data[--_currentOffset]};
+	if (_linkedInputStream) _linkedInputStream->setEndOffset(_currentOffset);
+	return ret;
+}
+
 
 template<typename T>
 class LSBBitReader
@@ -239,6 +262,164 @@ private:
 	uint8_t			_bufLength{0};
 };
 
+
+// Byte-oriented bit readers with 64-bit bit buffer and peek/consume.
+// Refill loads multiple bytes at once when far enough from the end of the stream.
+// Peeking past the end of the stream returns zero bits, consuming past it is an error.
+// Since bytes are read ahead, call reset() before using the underlying stream directly:
+// it will drop the partially consumed byte and return the unused bytes to the stream
+template<typename T>
+class LSBBitReader64
+{
+public:
+	LSBBitReader64(T &inputStream) noexcept :
+		_inputStream{inputStream}
+	{
+		// nothing needed
+	}
+	~LSBBitReader64() noexcept=default;
+
+	uint32_t peekBits(uint32_t count)
+	{
+		if (count>32U)
+			throw Decompressor::DecompressionError();
+		if (_bufLength<count) refill();
+		return uint32_t(_bufContent&((uint64_t(1U)<<count)-1U));
+	}
+
+	void consumeBits(uint32_t count)
+	{
+		if (count>32U)
+			throw Decompressor::DecompressionError();
+		if (_bufLength<count)
+		{
+			refill();
+			if (_bufLength<count)
+				throw Decompressor::DecompressionError();
+		}
+		_bufContent>>=count;
+		_bufLength-=count;
+	}
+
+	uint32_t readBits(uint32_t count)
+	{
+		uint32_t ret{peekBits(count)};
+		consumeBits(count);
+		return ret;
+	}
+
+	void reset()
+	{
+		_inputStream.setOffset(_inputStream.getOffset()-(_bufLength>>3U));
+		_bufContent=0;
+		_bufLength=0;
+	}
+
+	size_t available() const noexcept { return _inputStream.available()*8U+_bufLength; }
+
+private:
+	void refill()
+	{
+		uint32_t count{(64U-_bufLength)>>3U};
+		if (_inputStream.available()>=count)
+		{
+			const uint8_t *ptr{_inputStream.readDirect(count)};
+			for (uint32_t i=0;i<count;i++,_bufLength+=8U)
+				_bufContent|=uint64_t(ptr[i])<<_bufLength;
+		} else {
+			while (_bufLength<=56U && !_inputStream.eof())
+			{
+				_bufContent|=uint64_t(_inputStream.readByte())<<_bufLength;
+				_bufLength+=8U;
+			}
+		}
+	}
+
+	T			&_inputStream;
+	uint64_t		_bufContent{0};
+	uint32_t		_bufLength{0};
+};
+
+
+template<typename T>
+class MSBBitReader64
+{
+public:
+	MSBBitReader64(T &inputStream) noexcept :
+		_inputStream{inputStream}
+	{
+		// nothing needed
+	}
+	~MSBBitReader64() noexcept=default;
+
+	uint32_t peekBits(uint32_t count)
+	{
+		if (count>32U)
+			throw Decompressor::DecompressionError();
+		// shift by 64 would be undefined with full buffer
+		if (!count) return 0;
+		if (_bufLength<count)
+		{
+			refill();
+			if (_bufLength<count)
+				return uint32_t((_bufContent<<(count-_bufLength))&((uint64_t(1U)<<count)-1U));
+		}
+		return uint32_t((_bufContent>>(_bufLength-count))&((uint64_t(1U)<<count)-1U));
+	}
+
+	void consumeBits(uint32_t count)
+	{
+		if (count>32U)
+			throw Decompressor::DecompressionError();
+		if (_bufLength<count)
+		{
+			refill();
+			if (_bufLength<count)
+				throw Decompressor::DecompressionError();
+		}
+		_bufLength-=count;
+	}
+
+	uint32_t readBits(uint32_t count)
+	{
+		uint32_t ret{peekBits(count)};
+		consumeBits(count);
+		return ret;
+	}
+
+	void reset()
+	{
+		_inputStream.setOffset(_inputStream.getOffset()-(_bufLength>>3U));
+		_bufContent=0;
+		_bufLength=0;
+	}
+
+	size_t available() const noexcept { return _inputStream.available()*8U+_bufLength; }
+
+private:
+	void refill()
+	{
+		uint32_t count{(64U-_bufLength)>>3U};
+		if (_inputStream.available()>=count)
+		{
+			const uint8_t *ptr{_inputStream.readDirect(count)};
+			for (uint32_t i=0;i<count;i++)
+				_bufContent=(_bufContent<<8U)|uint64_t(ptr[i]);
+			_bufLength+=count<<3U;
+		} else {
+			while (_bufLength<=56U && !_inputStream.eof())
+			{
+				_bufContent=(_bufContent<<8U)|uint64_t(_inputStream.readByte());
+				_bufLength+=8U;
+			}
+		}
+	}
+
+	T			&_inputStream;
+	uint64_t		_bufContent{0};
+	uint32_t		_bufLength{0};
+};
+
 }
 
 #endif
@@ -41,14 +41,18 @@ const std::string &LHDecompressor::getSubName() const noexcept
 size_t LHDecompressor::decompressLhLib(Buffer &rawData,const Buffer &packedData)
 {
 	ForwardInputStream inputStream{packedData,0,packedData.size()};
-	MSBBitReader<ForwardInputStream> bitReader{inputStream};
+	MSBBitReader64<ForwardInputStream> bitReader{inputStream};
 	auto readBits=[&](uint32_t count)->uint32_t
 	{
-		return bitReader.readBitsBE16(count);
+		return bitReader.readBits(count);
 	};
-	auto readBit=[&]()->uint32_t
+	auto peekBits=[&](uint32_t count)->uint32_t
 	{
-		return bitReader.readBitsBE16(1U);
+		return bitReader.peekBits(count);
+	};
+	auto consumeBits=[&](uint32_t count)
+	{
+		bitReader.consumeBits(count);
 	};
 
 	ForwardOutputStream outputStream(rawData,0,rawData.size());
@@ -61,11 +65,12 @@ size_t LHDecompressor::decompressLhLib(Buffer &rawData,const Buffer &packedData)
 	// - different distance/count logic
 
 	DynamicHuffmanDecoder<317> decoder;
+	decoder.createLookupTable(8U,false);
 	VariableLengthCodeDecoder vlcDecoder{5,5,6,6,6,7,7,7,7,8,8,8,9,9,9,10};
 
 	while (!outputStream.eof())
 	{
-		uint32_t code=decoder.decode(readBit);
+		uint32_t code=decoder.decode(peekBits,consumeBits);
 		if (code==316U) break;
 		if (decoder.getMaxFrequency()<0x8000U) decoder.update(code);
 
@@ -139,7 +139,7 @@ void LIN2Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	ForwardOutputStream outputStream{rawData,0,rawSize};
 
 	// little meh to initialize both (intentionally deleted copy/assign)
-	HuffmanDecoder<uint8_t> lengthDecoder2
+	static constexpr StaticHuffmanDecoder<uint8_t,12> lengthDecoder2
 	{
 		HuffmanCode{1,0b000000,uint8_t{3}},
 		HuffmanCode{3,0b000100,uint8_t{4}},
@@ -155,7 +155,7 @@ void LIN2Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		HuffmanCode{6,0b111111,uint8_t{0}}
 	};
 
-	HuffmanDecoder<uint8_t> lengthDecoder4
+	static constexpr StaticHuffmanDecoder<uint8_t,14> lengthDecoder4
 	{
 		HuffmanCode{2,0b0000000,uint8_t{3}},
 		HuffmanCode{2,0b0000001,uint8_t{4}},
@@ -172,7 +172,11 @@ void LIN2Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		HuffmanCode{7,0b1111110,uint8_t{15}},
 		HuffmanCode{7,0b1111111,uint8_t{0}}
 	};
-	auto &lengthDecoder=_ver==2?lengthDecoder2:lengthDecoder4;
+	auto decodeLength=[&]()->uint32_t
+	{
+		auto readLengthBit=[&](){return readBits(1);};
+		return _ver==2?lengthDecoder2.decode(readLengthBit):lengthDecoder4.decode(readLengthBit);
+	};
 
 	uint32_t minBits{1};
 
@@ -190,7 +194,7 @@ void LIN2Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 				} else outputStream.writeByte(literalTable[read4Bits(false)]);
 			}
 		} else {
-			uint32_t count=lengthDecoder.decode([&](){return readBits(1);});
+			uint32_t count=decodeLength();
 			if (!count)
 			{
 				count=readBits(4U);
@@ -110,10 +110,6 @@ void LOBDecompressor::decompressRound(Buffer &rawData,const Buffer &packedData)
 	};
 
 	ForwardOutputStream outputStream{rawData,0,rawSize};
-	auto writeByte=[&](uint8_t value)
-	{
-		outputStream.writeByte(value);
-	};
 
 	switch (method)
 	{
@@ -193,7 +189,7 @@ void LOBDecompressor::decompressRound(Buffer &rawData,const Buffer &packedData)
 		{
 			uint32_t firstCode{readBits(12U)};
 			LZWDecoder decoder{4096U,256U,65536U,firstCode};
-			decoder.write(firstCode,false,writeByte);
+			decoder.write(firstCode,false,outputStream);
 			while (!outputStream.eof())
 			{
 				uint32_t code{readBits(12U)};
@@ -201,9 +197,9 @@ void LOBDecompressor::decompressRound(Buffer &rawData,const Buffer &packedData)
 				{
 					firstCode=readBits(12U);
 					decoder.reset(firstCode);
-					decoder.write(firstCode,false,writeByte);
+					decoder.write(firstCode,false,outputStream);
 				} else {
-					decoder.write(code,!decoder.isLiteral(code),writeByte);
+					decoder.write(code,!decoder.isLiteral(code),outputStream);
 					decoder.add(code);
 				}
 			}
@@ -218,7 +214,7 @@ void LOBDecompressor::decompressRound(Buffer &rawData,const Buffer &packedData)
 			if (!firstCode--)
 				throw DecompressionError();
 			LZWDecoder decoder{4096U,256U,65536U,firstCode};
-			decoder.write(firstCode,false,writeByte);
+			decoder.write(firstCode,false,outputStream);
 			while (!outputStream.eof())
 			{
 				if (codeBits!=12U && decoder.getCurrentIndex()+1U>=(1U<<codeBits))
@@ -231,9 +227,9 @@ void LOBDecompressor::decompressRound(Buffer &rawData,const Buffer &packedData)
 					if (!firstCode--)
 						throw DecompressionError();
 					decoder.reset(firstCode);
-					decoder.write(firstCode,false,writeByte);
+					decoder.write(firstCode,false,outputStream);
 				} else {
-					decoder.write(code,!decoder.isLiteral(code),writeByte);
+					decoder.write(code,!decoder.isLiteral(code),outputStream);
 					decoder.add(code);
 				}
 			}
@@ -243,7 +239,7 @@ void LOBDecompressor::decompressRound(Buffer &rawData,const Buffer &packedData)
 		// MSP (something lz)
 		case 5U:
 		{
-			HuffmanDecoder<uint8_t> decoder
+			static constexpr StaticHuffmanDecoder<uint8_t,6> decoder
 			{
 				HuffmanCode{2,0b000,uint8_t{0}},
 				HuffmanCode{2,0b001,uint8_t{1}},
@@ -11,11 +11,11 @@
 namespace ancient::internal
 {
 
-template<size_t T>
+template<size_t T,typename D>
 class FrequencyDecoder
 {
 public:
-	FrequencyDecoder(RangeDecoder &decoder) :
+	FrequencyDecoder(D &decoder) :
 		_decoder{decoder}
 	{
 		// nothing needed
@@ -54,7 +54,7 @@ public:
 	}
 
 private:
-	RangeDecoder					&_decoder;
+	D						&_decoder;
 	FrequencyTree<uint16_t,uint16_t,T+1>		_tree;
 	uint16_t					_threshold{1};
 };
@@ -85,7 +85,7 @@ const std::string &LZCBDecompressor::getSubName() const noexcept
 
 void LZCBDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
-	class BitReader : public RangeDecoder::BitReader
+	class BitReader
 	{
 	public:
 		BitReader(ForwardInputStream &stream) :
@@ -95,11 +95,6 @@ void LZCBDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		}
 		~BitReader() noexcept=default;
 
-		uint32_t readBit() final
-		{
-			return _reader.readBitsBE32(1);
-		}
-
 		uint32_t readBits(uint32_t bitCount)
 		{
 			return _reader.readBitsBE32(bitCount);
@@ -113,7 +108,7 @@ void LZCBDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	ForwardOutputStream outputStream{rawData,0,rawData.size()};
 	BitReader bitReader{inputStream};
 
-	RangeDecoder rangeDecoder{bitReader,uint16_t(bitReader.readBits(16))};
+	DirectRangeDecoder<BitReader> rangeDecoder{bitReader,uint16_t(bitReader.readBits(16))};
 
 	// Ugly duplicates
 	auto readByte=[&]()->uint16_t
@@ -130,12 +125,15 @@ void LZCBDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		return ret;
 	};
 
-	FrequencyDecoder<256> baseLiteralDecoder{rangeDecoder};
-	FrequencyDecoder<257> repeatCountDecoder{rangeDecoder};
-	FrequencyDecoder<257> literalCountDecoder{rangeDecoder};
-	FrequencyDecoder<256> distanceDecoder{rangeDecoder};
+	using ByteDecoder=FrequencyDecoder<256,decltype(rangeDecoder)>;
+	using CountDecoder=FrequencyDecoder<257,decltype(rangeDecoder)>;
+
+	ByteDecoder baseLiteralDecoder{rangeDecoder};
+	CountDecoder repeatCountDecoder{rangeDecoder};
+	CountDecoder literalCountDecoder{rangeDecoder};
+	ByteDecoder distanceDecoder{rangeDecoder};
 
-	std::array<std::unique_ptr<FrequencyDecoder<256>>,256> literalDecoders;
+	std::array<std::unique_ptr<ByteDecoder>,256> literalDecoders;
 
 	uint8_t ch{uint8_t(baseLiteralDecoder.decode(readByte))};
 	outputStream.writeByte(ch);
@@ -172,7 +170,7 @@ void LZCBDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 				for (uint32_t i=0;i<literalCount;i++)
 				{
 					auto &literalDecoder{literalDecoders[ch]};
-					if (!literalDecoder) literalDecoder=std::make_unique<FrequencyDecoder<256>>(rangeDecoder);
+					if (!literalDecoder) literalDecoder=std::make_unique<ByteDecoder>(rangeDecoder);
 					ch=uint8_t(literalDecoder->decode([&]()
 					{
 						return baseLiteralDecoder.decode(readByte);
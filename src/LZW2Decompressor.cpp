@@ -35,6 +35,11 @@ const std::string &LZW2Decompressor::getSubName() const noexcept
 	return (_ver==2)?name2:name3;
 }
 
+bool LZW2Decompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void LZW2Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,0,_packedData.size()};
@@ -33,6 +33,11 @@ const std::string &LZW4Decompressor::getSubName() const noexcept
 	return name;
 }
 
+bool LZW4Decompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void LZW4Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,0,_packedData.size()};
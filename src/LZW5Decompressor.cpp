@@ -33,6 +33,11 @@ const std::string &LZW5Decompressor::getSubName() const noexcept
 	return name;
 }
 
+bool LZW5Decompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void LZW5Decompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,0,_packedData.size()};
@@ -15,6 +15,9 @@ LZWDecoder::LZWDecoder(uint32_t maxCode,uint32_t literalCodes,uint32_t stackLeng
 	_prevCode{firstCode},
 	_prefix{std::make_unique<uint32_t[]>(maxCode-literalCodes)},
 	_suffix{std::make_unique<uint8_t[]>(maxCode-literalCodes)},
+	_length{std::make_unique<uint32_t[]>(maxCode-literalCodes)},
+	_first{std::make_unique<uint8_t[]>(maxCode-literalCodes)},
+	_offset{std::make_unique<size_t[]>(maxCode-literalCodes)},
 	_stack{std::make_unique<uint8_t[]>(stackLength)}
 {
 	// nothing needed
@@ -30,11 +33,88 @@ void LZWDecoder::add(uint32_t code)
 {
 	if (_freeIndex<_maxCode)
 	{
-		_suffix[_freeIndex-_literalCodes]=_newCode;
-		_prefix[_freeIndex-_literalCodes]=_prevCode;
+		uint32_t index{_freeIndex-_literalCodes};
+		_suffix[index]=_newCode;
+		_prefix[index]=_prevCode;
+		// new string is the previous one followed by the first character of the current one,
+		// thus it can be found where the previous string was written
+		if (_prevCode<_literalCodes)
+		{
+			_length[index]=2U;
+			_first[index]=_prevCode;
+		} else if (_prevCode<_freeIndex) {
+			uint32_t prevIndex{_prevCode-_literalCodes};
+			_length[index]=_length[prevIndex]?_length[prevIndex]+1U:0;
+			_first[index]=_first[prevIndex];
+		} else {
+			// broken stream. Prefix might become valid later though
+			_length[index]=0;
+		}
+		_offset[index]=_prevWriteOffset;
 		_freeIndex++;
 	}
 	_prevCode=code;
 }
 
+void LZWDecoder::write(uint32_t code,bool addNew,ForwardOutputStreamBase &outputStream)
+{
+	uint32_t tmp{_newCode};
+	if (addNew) code=_prevCode;
+	if (code>=_freeIndex)
+		throw Decompressor::DecompressionError();
+
+	_prevWriteOffset=_writeOffset;
+	_writeOffset=outputStream.getOffset();
+	if (code<_literalCodes)
+	{
+		_newCode=code;
+		outputStream.writeByte(code);
+	} else if (uint32_t index{code-_literalCodes},length{_length[index]};!length) {
+		writeSlow(code,outputStream);
+	} else {
+		if (length>_stackLength || outputStream.reserve(length)<length)
+			throw Decompressor::DecompressionError();
+		_newCode=_first[index];
+		if (size_t distance{outputStream.getOffset()-_offset[index]};distance<=outputStream.getAvailableHistory())
+		{
+			outputStream.copyUnchecked(distance,length);
+		} else {
+			// not in history anymore, walk the prefixes and write the string back to front
+			uint8_t *dest{outputStream.writeSpanUnchecked(length)};
+			for (uint32_t i=length-1U;i;i--)
+			{
+				dest[i]=_suffix[index];
+				code=_prefix[index];
+				index=code-_literalCodes;
+			}
+			dest[0]=uint8_t(code);
+		}
+	}
+	if (addNew) outputStream.writeByte(tmp);
+}
+
+// strings that could not be resolved when they were added, prefixes are checked on the go
+void LZWDecoder::writeSlow(uint32_t code,ForwardOutputStreamBase &outputStream)
+{
+	auto suffixLookup=[&](uint32_t value)->uint32_t
+	{
+		if (value>=_freeIndex)
+			throw Decompressor::DecompressionError();
+		return (value<_literalCodes)?value:_suffix[value-_literalCodes];
+	};
+
+	uint32_t stackPos{0};
+	_newCode=suffixLookup(code);
+	while (code>=_literalCodes)
+	{
+		if (stackPos+1>=_stackLength)
+			throw Decompressor::DecompressionError();
+		_stack[stackPos++]=_newCode;
+		code=_prefix[code-_literalCodes];
+		_newCode=suffixLookup(code);
+	}
+	_stack[stackPos++]=_newCode;
+	while (stackPos) outputStream.writeByte(_stack[--stackPos]);
+}
+
 }
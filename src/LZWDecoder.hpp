@@ -20,34 +20,9 @@ public:
 	void reset(uint32_t firstCode);
 	void add(uint32_t code);
 
-	template<typename F>
-	void write(uint32_t code,bool addNew,F func)
-	{
-		auto suffixLookup=[&](uint32_t value)->uint32_t
-		{
-			if (value>=_freeIndex)
-				throw Decompressor::DecompressionError();
-			return (value<_literalCodes)?value:_suffix[value-_literalCodes];
-		};
-
-		uint32_t stackPos{0};
-
-		uint32_t tmp{_newCode};
-		if (addNew) code=_prevCode;
-
-		_newCode=suffixLookup(code);
-		while (code>=_literalCodes)
-		{
-			if (stackPos+1>=_stackLength)
-				throw Decompressor::DecompressionError();
-			_stack[stackPos++]=_newCode;
-			code=_prefix[code-_literalCodes];
-			_newCode=suffixLookup(code);
-		}
-		_stack[stackPos++]=_newCode;
-		while (stackPos) func(_stack[--stackPos]);
-		if (addNew) func(tmp);
-	}
+	// All of the output must be written through here, since strings are copied
+	// from their earlier occurrences in the output when still available in the history
+	void write(uint32_t code,bool addNew,ForwardOutputStreamBase &outputStream);
 
 	bool isLiteral(uint32_t code) { return code<_freeIndex; }
 
@@ -56,6 +31,8 @@ public:
 	uint32_t getCurrentIndex() { return _freeIndex; }
 
 private:
+	void writeSlow(uint32_t code,ForwardOutputStreamBase &outputStream);
+
 	uint32_t	_maxCode;
 	uint32_t	_literalCodes;
 	uint32_t	_stackLength;
@@ -64,8 +41,16 @@ private:
 	uint32_t	_prevCode;
 	uint32_t	_newCode{0};
 
+	// where the latest two strings were written
+	size_t		_writeOffset{0};
+	size_t		_prevWriteOffset{0};
+
 	std::unique_ptr<uint32_t[]> _prefix;
 	std::unique_ptr<uint8_t[]> _suffix;
+	// length of 0 marks a string that can not be resolved yet
+	std::unique_ptr<uint32_t[]> _length;
+	std::unique_ptr<uint8_t[]> _first;
+	std::unique_ptr<size_t[]> _offset;
 	std::unique_ptr<uint8_t[]> _stack;
 };
 
@@ -204,11 +204,14 @@ void LZXDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,
 			createHuffmanTable(literalDecoder,literalTable,768U);
 		}
 		
+		// output is checked once per block
+		if (outputStream.reserve(blockLength)<blockLength)
+			throw Decompressor::DecompressionError();
 		while (blockLength)
 		{
 			uint32_t symbol{literalDecoder.decode(readBit)};
 			if (symbol<256U) {
-				outputStream.writeByte(symbol);
+				outputStream.writeByteUnchecked(symbol);
 				blockLength--;
 			} else {
 				symbol-=256U;
@@ -228,7 +231,7 @@ void LZXDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,
 				uint32_t count{vlcDecoder.decode(readBits,symbol>>5U)+3U};
 				if (count>blockLength)
 					throw Decompressor::DecompressionError();
-				outputStream.copy(distance,count);
+				outputStream.copyUnchecked(distance,count);
 				blockLength-=count;
 			}
 		}
@@ -35,6 +35,11 @@ const std::string &MASHDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool MASHDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void MASHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,0,_packedData.size()};
@@ -55,7 +60,7 @@ void MASHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	size_t rawSize{rawData.size()};
 	ForwardOutputStream outputStream{rawData,0,rawSize};
 
-	HuffmanDecoder<uint32_t> litDecoder
+	static constexpr StaticHuffmanDecoder<uint32_t,7> litDecoder
 	{
 		HuffmanCode{1,0b000000,0U},
 		HuffmanCode{2,0b000010,1U},
@@ -15,6 +15,7 @@ public:
 	~MASHDecompressor() noexcept=default;
 
 	const std::string &getSubName() const noexcept final;
+	bool isChunkIndependent() const noexcept final;
 
 	void decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify) final;
 
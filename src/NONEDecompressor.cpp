@@ -33,6 +33,11 @@ const std::string &NONEDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool NONEDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void NONEDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	if (rawData.size()!=_packedData.size())
@@ -39,6 +39,11 @@ const std::string &NUKEDecompressor::getSubName() const noexcept
 	return (_isDUKE)?nameD:nameN;
 }
 
+bool NUKEDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void NUKEDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	// there are 2 streams, reverse stream for bytes and
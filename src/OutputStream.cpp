@@ -9,43 +9,84 @@
 #include "Decompressor.hpp"
 #include "common/Common.hpp"
 #include "common/OverflowCheck.hpp"
+#include "common/SubBuffer.hpp"
 
 
 namespace ancient::internal
 {
 
+// LZ-style copy where the source is distance bytes before dest and they may overlap.
+// Overlapping copy repeats the pattern, thus after copying distance bytes the
+// distance can be doubled. This way everything is done with non-overlapping memcpys
+static void copyForward(uint8_t *dest,size_t distance,size_t count)
+{
+	if (distance==1U)
+	{
+		std::memset(dest,dest[-1],count);
+		return;
+	}
+	while (count>distance)
+	{
+		std::memcpy(dest,dest-distance,distance);
+		dest+=distance;
+		count-=distance;
+		distance<<=1;
+	}
+	std::memcpy(dest,dest-distance,count);
+}
+
+// Same as above, but dest is the end of the destination and the copy goes backwards
+static void copyBackward(uint8_t *dest,size_t distance,size_t count)
+{
+	if (distance==1U)
+	{
+		std::memset(dest-count,dest[0],count);
+		return;
+	}
+	while (count>distance)
+	{
+		dest-=distance;
+		std::memcpy(dest,dest+distance,distance);
+		count-=distance;
+		distance<<=1;
+	}
+	std::memcpy(dest-count,dest-count+distance,count);
+}
+
 ForwardOutputStreamBase::ForwardOutputStreamBase(Buffer &buffer,size_t startOffset) :
 	_buffer{buffer},
 	_startOffset{startOffset},
 	_currentOffset{startOffset}
 {
-	// should call ensureSize but can't
+	// nothing needed, _limit of 0 makes the first write call reserveSpace
 }
 
-void ForwardOutputStreamBase::writeByte(uint8_t value)
+uint8_t ForwardOutputStreamBase::copy(size_t distance,size_t count)
 {
-	ensureSize(_currentOffset+1);
-	_buffer[_currentOffset++]=value;
+	ensureSpace(count);
+	return copyUnchecked(distance,count);
 }
 
-uint8_t ForwardOutputStreamBase::copy(size_t distance,size_t count)
+uint8_t ForwardOutputStreamBase::copyUnchecked(size_t distance,size_t count)
 {
-	ensureSize(OverflowCheck::sum(_currentOffset,count));
 	if (!distance || OverflowCheck::sum(_startOffset,distance)>_currentOffset)
 		throw Decompressor::DecompressionError();
-	uint8_t ret{0};
-	for (size_t i=0;i<count;i++,_currentOffset++)
-		ret=_buffer[_currentOffset]=_buffer[_currentOffset-distance];
-	return ret;
+	if (!count) return 0;
+	// range is checked above
+	uint8_t *dest{_data+_currentOffset};
+	copyForward(dest,distance,count);
+	_currentOffset+=count;
+	return dest[count-1];
 }
 
 uint8_t ForwardOutputStreamBase::copy(size_t distance,size_t count,const Buffer &prevBuffer)
 {
-	ensureSize(OverflowCheck::sum(_currentOffset,count));
+	ensureSpace(count);
 	if (!distance)
 		throw Decompressor::DecompressionError();
+	if (!count) return 0;
 	size_t prevCount{0};
-	uint8_t ret{0};
+	uint8_t *dest{_data+_currentOffset};
 	if (OverflowCheck::sum(_startOffset,distance)>_currentOffset)
 	{
 		size_t prevSize{prevBuffer.size()};
@@ -53,51 +94,52 @@ uint8_t ForwardOutputStreamBase::copy(size_t distance,size_t count,const Buffer
 			throw Decompressor::DecompressionError(); 
 		size_t prevDist{_startOffset+distance-_currentOffset};
 		prevCount=std::min(count,prevDist);
-		const uint8_t *prev{&prevBuffer[prevSize-prevDist]};
-		for (size_t i=0;i<prevCount;i++,_currentOffset++)
-			ret=_buffer[_currentOffset]=prev[i];
+		std::memcpy(dest,prevBuffer.data()+prevSize-prevDist,prevCount);
 	}
-	for (size_t i=prevCount;i<count;i++,_currentOffset++)
-		ret=_buffer[_currentOffset]=_buffer[_currentOffset-distance];
-	return ret;
+	if (prevCount!=count)
+		copyForward(dest+prevCount,distance,count-prevCount);
+	_currentOffset+=count;
+	return dest[count-1];
 }
 
 uint8_t ForwardOutputStreamBase::copy(size_t distance,size_t count,uint8_t defaultChar)
 {
-	ensureSize(OverflowCheck::sum(_currentOffset,count));
+	ensureSpace(count);
 	if (!distance)
 		throw Decompressor::DecompressionError();
+	if (!count) return 0;
 	size_t prevCount{0};
-	uint8_t ret{0};
+	uint8_t *dest{_data+_currentOffset};
 	if (OverflowCheck::sum(_startOffset,distance)>_currentOffset)
 	{
 		prevCount=std::min(count,_startOffset+distance-_currentOffset);
-		for (size_t i=0;i<prevCount;i++,_currentOffset++)
-			ret=_buffer[_currentOffset]=defaultChar;
+		std::memset(dest,defaultChar,prevCount);
 	}
-	for (size_t i=prevCount;i<count;i++,_currentOffset++)
-		ret=_buffer[_currentOffset]=_buffer[_currentOffset-distance];
-	return ret;
+	if (prevCount!=count)
+		copyForward(dest+prevCount,distance,count-prevCount);
+	_currentOffset+=count;
+	return dest[count-1];
 }
 
 const uint8_t *ForwardOutputStreamBase::history(size_t distance) const
 {
 	if (OverflowCheck::sum(distance,_startOffset)>_currentOffset)
 		throw Decompressor::DecompressionError();
-	return &_buffer[_currentOffset-distance];
+	return _data+_currentOffset-distance;
 }
 
 uint8_t *ForwardOutputStreamBase::history(size_t distance)
 {
 	if (OverflowCheck::sum(distance,_startOffset)>_currentOffset)
 		throw Decompressor::DecompressionError();
-	return &_buffer[_currentOffset-distance];
+	return _data+_currentOffset-distance;
 }
 
 void ForwardOutputStreamBase::produce(const Buffer &src)
 {
-	ensureSize(OverflowCheck::sum(_currentOffset,src.size()));
-	std::memcpy(&_buffer[_currentOffset],src.data(),src.size());
+	if (!src.size()) return;
+	ensureSpace(src.size());
+	std::memcpy(_data+_currentOffset,src.data(),src.size());
 	_currentOffset+=src.size();
 }
 
@@ -109,6 +151,8 @@ ForwardOutputStream::ForwardOutputStream(Buffer &buffer,size_t startOffset,size_
 {
 	if (_startOffset>_endOffset || _endOffset>_buffer.size())
 		throw Decompressor::DecompressionError();
+	_data=_buffer.data();
+	_limit=_endOffset;
 }
 
 void ForwardOutputStream::reset(size_t startOffset,size_t endOffset)
@@ -117,20 +161,28 @@ void ForwardOutputStream::reset(size_t startOffset,size_t endOffset)
 	_endOffset=endOffset;
 	if (_startOffset>_endOffset || _endOffset>_buffer.size())
 		throw Decompressor::DecompressionError();
+	_data=_buffer.data();
+	_limit=_endOffset;
 }
 
-void ForwardOutputStream::ensureSize(size_t offset)
+void ForwardOutputStream::reserveSpace(size_t count)
 {
-	if (offset>_endOffset)
-		throw Decompressor::DecompressionError();
+	// fixed size, _limit is already at the end
 }
 
 // ---
 
-AutoExpandingForwardOutputStream::AutoExpandingForwardOutputStream(Buffer &buffer) :
-	ForwardOutputStreamBase{buffer,0}
+AutoExpandingForwardOutputStream::AutoExpandingForwardOutputStream(Buffer &buffer,const Decompressor::OutputSink *sink,size_t historySize,size_t sizeHint) :
+	ForwardOutputStreamBase{buffer,0},
+	_sink{sink},
+	_historySize{historySize}
 {
-	// nothing needed
+	sizeHint=std::min(sizeHint,Decompressor::getMaxRawSize());
+	if (!_sink && sizeHint>_buffer.size() && _buffer.isResizable())
+	{
+		_buffer.resize(sizeHint);
+		_hasExpanded=true;
+	}
 }
 
 AutoExpandingForwardOutputStream::~AutoExpandingForwardOutputStream() noexcept
@@ -140,21 +192,48 @@ AutoExpandingForwardOutputStream::~AutoExpandingForwardOutputStream() noexcept
 		_buffer.resize(_currentOffset);
 }
 
-void AutoExpandingForwardOutputStream::ensureSize(size_t offset)
+void AutoExpandingForwardOutputStream::flush()
 {
-	if (offset>Decompressor::getMaxRawSize())
-		throw Decompressor::DecompressionError();
+	if (_sink && _currentOffset!=_sinkOffset)
+	{
+		(*_sink)(ConstSubBuffer{_buffer,_sinkOffset,_currentOffset-_sinkOffset});
+		_sinkOffset=_currentOffset;
+	}
+}
+
+void AutoExpandingForwardOutputStream::reserveSpace(size_t count)
+{
+	// no growing past the maximum size
+	size_t offset{_currentOffset+std::min(count,Decompressor::getMaxRawSize()-_discardedSize-_currentOffset)};
 	if (offset>_buffer.size())
 	{
-		_buffer.resize(offset+_advance);
-		_hasExpanded=true;
+		if (_sink && _currentOffset>_historySize)
+		{
+			// slide the window instead of growing the buffer
+			flush();
+			size_t discard{_currentOffset-_historySize};
+			std::memmove(_buffer.data(),_buffer.data()+discard,_historySize);
+			_currentOffset-=discard;
+			_sinkOffset-=discard;
+			_discardedSize+=discard;
+			offset-=discard;
+		}
+		if (offset>_buffer.size() && _buffer.isResizable())
+		{
+			// grow geometrically to keep the number of reallocations down
+			_buffer.resize(std::max(offset+_advance,std::min(_buffer.size()*2U,Decompressor::getMaxRawSize()-_discardedSize)));
+			_hasExpanded=true;
+		}
 	}
+	// resize might have moved the data
+	_data=_buffer.data();
+	_limit=std::min(_buffer.size(),Decompressor::getMaxRawSize()-_discardedSize);
 }
 
 // ---
 
 BackwardOutputStream::BackwardOutputStream(Buffer &buffer,size_t startOffset,size_t endOffset) :
-	_buffer{buffer},
+	_data{buffer.data()},
 	_startOffset{startOffset},
 	_currentOffset{endOffset},
 	_endOffset{endOffset}
@@ -163,38 +242,34 @@ BackwardOutputStream::BackwardOutputStream(Buffer &buffer,size_t startOffset,siz
 		throw Decompressor::DecompressionError();
 }
 
-void BackwardOutputStream::writeByte(uint8_t value)
-{
-	if (_currentOffset<=_startOffset)
-		throw Decompressor::DecompressionError();
-	_buffer[--_currentOffset]=value;
-}
-
 uint8_t BackwardOutputStream::copy(size_t distance,size_t count)
 {
 	if (!distance || OverflowCheck::sum(_startOffset,count)>_currentOffset || OverflowCheck::sum(_currentOffset,distance)>_endOffset)
 		throw Decompressor::DecompressionError();
-	uint8_t ret{0};
-	for (size_t i=0;i<count;i++,--_currentOffset)
-		ret=_buffer[_currentOffset-1]=_buffer[_currentOffset+distance-1];
-	return ret;
+	if (!count) return 0;
+	// range is checked above
+	uint8_t *dest{_data+_currentOffset};
+	copyBackward(dest,distance,count);
+	_currentOffset-=count;
+	return dest[-ptrdiff_t(count)];
 }
 
 uint8_t BackwardOutputStream::copy(size_t distance,size_t count,uint8_t defaultChar)
 {
 	if (!distance || OverflowCheck::sum(_startOffset,count)>_currentOffset)
 		throw Decompressor::DecompressionError();
+	if (!count) return 0;
 	size_t prevCount{0};
-	uint8_t ret{0};
+	uint8_t *dest{_data+_currentOffset};
 	if (OverflowCheck::sum(_currentOffset,distance)>_endOffset)
 	{
 		prevCount=std::min(count,_currentOffset+distance-_endOffset);
-		for (size_t i=0;i<prevCount;i++,--_currentOffset)
-			ret=_buffer[_currentOffset-1]=defaultChar;
+		std::memset(dest-prevCount,defaultChar,prevCount);
 	}
-	for (size_t i=prevCount;i<count;i++,--_currentOffset)
-		ret=_buffer[_currentOffset-1]=_buffer[_currentOffset+distance-1];
-	return ret;
+	if (prevCount!=count)
+		copyBackward(dest-prevCount,distance,count-prevCount);
+	_currentOffset-=count;
+	return dest[-ptrdiff_t(count)];
 }
 
 }
@@ -7,6 +7,7 @@
 #include <cstdint>
 
 #include "common/Buffer.hpp"
+#include "Decompressor.hpp"
 
 namespace ancient::internal
 {
@@ -17,7 +18,11 @@ public:
 	ForwardOutputStreamBase(Buffer &buffer,size_t startOffset);
 	virtual ~ForwardOutputStreamBase() noexcept=default;
 
-	void writeByte(uint8_t value);
+	void writeByte(uint8_t value)
+	{
+		ensureSpace(1U);
+		_data[_currentOffset++]=value;
+	}
 
 	uint8_t copy(size_t distance,size_t count);
 	uint8_t copy(size_t distance,size_t count,const Buffer &prevBuffer);
@@ -26,14 +31,59 @@ public:
 	const uint8_t *history(size_t distance) const;
 	void produce(const Buffer &src);
 
-	size_t getOffset() const { return _currentOffset; }
+	// Fast path for decoders: reserve space once and then write without checks.
+	// Returns the number of bytes that can be written with the unchecked functions.
+	// It is at least count unless the stream ends before that
+	size_t reserve(size_t count)
+	{
+		if (_limit-_currentOffset<count) reserveSpace(count);
+		return _limit-_currentOffset;
+	}
+
+	void writeByteUnchecked(uint8_t value) noexcept
+	{
+		_data[_currentOffset++]=value;
+	}
+
+	// returns the next count bytes of reserved space, for writing them in any order
+	uint8_t *writeSpanUnchecked(size_t count) noexcept
+	{
+		uint8_t *ret{_data+_currentOffset};
+		_currentOffset+=count;
+		return ret;
+	}
+
+	// space must be reserved, distance is still checked
+	uint8_t copyUnchecked(size_t distance,size_t count);
+
+	size_t getOffset() const { return _discardedSize+_currentOffset; }
+	// largest distance that can be used for copy
+	size_t getAvailableHistory() const { return _currentOffset-_startOffset; }
 
 protected:
-	virtual void ensureSize(size_t offset)=0;
+	// tries to make space for count bytes, must update _data and _limit.
+	// Does not throw if there is not enough space, ensureSpace takes care of it
+	virtual void reserveSpace(size_t count)=0;
+
+	void ensureSpace(size_t count)
+	{
+		if (_limit-_currentOffset<count)
+		{
+			reserveSpace(count);
+			if (_limit-_currentOffset<count)
+				throw Decompressor::DecompressionError();
+		}
+	}
 
 	Buffer		&_buffer;
 	size_t		_startOffset;
 	size_t		_currentOffset;
+	// amount of data already removed from the beginning of the buffer (streaming)
+	size_t		_discardedSize{0};
+
+	// cached buffer pointer, offsets below _limit can be written without calling reserveSpace
+	uint8_t		*_data{nullptr};
+	size_t		_limit{0};
 };
 
 class ForwardOutputStream : public ForwardOutputStreamBase
@@ -48,7 +98,7 @@ public:
 	size_t getEndOffset() const { return _endOffset; }
 
 protected:
-	void ensureSize(size_t offset) final;
+	void reserveSpace(size_t count) final;
 
 private:
 	size_t		_endOffset;
@@ -57,16 +107,27 @@ private:
 class AutoExpandingForwardOutputStream : public ForwardOutputStreamBase
 {
 public:
-	AutoExpandingForwardOutputStream(Buffer &buffer);
+	// With sink the stream keeps only historySize bytes of the already written data in the buffer.
+	// Older data is given to the sink when the buffer would need to grow.
+	// Remaining data must be given to the sink by calling flush once done.
+	// Without sink the buffer is allocated for sizeHint bytes up front, and grown geometrically after that
+	AutoExpandingForwardOutputStream(Buffer &buffer,const Decompressor::OutputSink *sink=nullptr,size_t historySize=0,size_t sizeHint=0);
 	~AutoExpandingForwardOutputStream() noexcept;
 
+	// give all the written data to the sink, history is still kept
+	void flush();
+
 protected:
-	void ensureSize(size_t offset) final;
+	void reserveSpace(size_t count) final;
 
 private:
 	static constexpr size_t _advance{65536U};
 
 	bool		_hasExpanded=false;
+
+	const Decompressor::OutputSink	*_sink;
+	size_t				_historySize;
+	size_t				_sinkOffset{0};
 };
 
 class BackwardOutputStream
@@ -75,7 +136,12 @@ public:
 	BackwardOutputStream(Buffer &buffer,size_t startOffset,size_t endOffset);
 	~BackwardOutputStream() noexcept=default;
 
-	void writeByte(uint8_t value);
+	void writeByte(uint8_t value)
+	{
+		if (_currentOffset<=_startOffset)
+			throw Decompressor::DecompressionError();
+		_data[--_currentOffset]=value;
+	}
 
 	uint8_t copy(size_t distance,size_t count);
 	uint8_t copy(size_t distance,size_t count,uint8_t defaultChar);
@@ -84,7 +150,7 @@ public:
 	size_t getOffset() const { return _currentOffset; }
 
 private:
-	Buffer		&_buffer;
+	uint8_t		*_data;
 	size_t		_startOffset;
 	size_t		_currentOffset;
 	size_t		_endOffset;
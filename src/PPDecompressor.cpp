@@ -1,10 +1,13 @@
 /* Copyright (C) Teemu Suutari */
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #include "PPDecompressor.hpp"
 #include "InputStream.hpp"
 #include "OutputStream.hpp"
+#include "common/Parallel.hpp"
 #include "common/Common.hpp"
 
 
@@ -229,11 +232,49 @@ size_t PPDecompressor::getRawSize() const noexcept
 
 	I think the code went from readable to whacky in this process. Sorry about that
 
+	Finally, the tree is split by the first few unknown key bits into tasks that are run in parallel.
+	Inside a task those bits are not branched, the prefix is used instead. Result is taken from the
+	first task finding the key, so it does not matter which thread finishes first. For the same reason
+	the iteration cutoff and the budget are split between the tasks instead of being shared.
+
 
 	In any case this should serve as a warning to anyone trying to create their own crypto.
 */
 
-void PPDecompressor::findKeyRound(BackwardInputStream &inputStream,LSBBitReader<BackwardInputStream> &bitReader,uint32_t keyBits,uint32_t keyMask,uint32_t outputPosition,uint32_t &iterCount)
+// shared between the tasks of a key search
+struct PPDecompressor::KeySearchControl
+{
+	std::atomic<uint32_t>	foundTask{~0U};		// lowest task with a result
+	std::atomic<bool>	stopped{false};
+};
+
+// Limits are per task, thus a task ends the same way no matter how the threads are scheduled
+struct PPDecompressor::KeySearch
+{
+	KeySearchControl	&control;
+	uint32_t		task;
+	uint32_t		fixedBits;		// task prefix
+	uint32_t		fixedMask;
+	size_t			cutoff;
+	size_t			budget;			// 0 for no limit
+	size_t			iterations{0};
+	uint32_t		iterCount{0};
+	bool			exhausted{false};	// key is accepted as is, like with the single threaded search
+	bool			cancelled{false};	// nothing is accepted
+	bool			overBudget{false};
+
+	// polled every now and then, not to slow down the search
+	void checkpoint()
+	{
+		iterations+=iterCount;
+		iterCount=0;
+		if (iterations>=cutoff) exhausted=true;
+		if (budget && iterations>budget) overBudget=cancelled=true;
+		if (control.stopped || control.foundTask<task) cancelled=true;
+	}
+};
+
+void PPDecompressor::findKeyRound(BackwardInputStream &inputStream,LSBBitReader<BackwardInputStream> &bitReader,uint32_t keyBits,uint32_t keyMask,uint32_t outputPosition,KeySearch &search) const
 {
 
 	uint32_t inputOffset;
@@ -260,6 +301,14 @@ void PPDecompressor::findKeyRound(BackwardInputStream &inputStream,LSBBitReader<
 		if ((keyMask>>bitPos)&1U)
 			return bit^((keyBits>>bitPos)&1U);
 
+		// bits of the task prefix are not branched
+		if ((search.fixedMask>>bitPos)&1U)
+		{
+			keyBits|=search.fixedBits&(1U<<bitPos);
+			keyMask|=1U<<bitPos;
+			return bit^((keyBits>>bitPos)&1U);
+		}
+
 		// meh
 		uint32_t tmpInputOffset{uint32_t(inputStream.getOffset())};
 		uint32_t tmpBufContent{bitReader.getBufContent()};
@@ -268,7 +317,7 @@ void PPDecompressor::findKeyRound(BackwardInputStream &inputStream,LSBBitReader<
 		// try 0
 		inputStream.setOffset(inputOffset);
 		bitReader.reset(bufContent,bufLength);
-		findKeyRound(inputStream,bitReader,keyBits,keyMask|(1U<<bitPos),savedOutputPosition,iterCount);
+		findKeyRound(inputStream,bitReader,keyBits,keyMask|(1U<<bitPos),savedOutputPosition,search);
 
 		// try 1
 		inputStream.setOffset(tmpInputOffset);
@@ -318,8 +367,7 @@ void PPDecompressor::findKeyRound(BackwardInputStream &inputStream,LSBBitReader<
 		bitReader.readBitsBE32(count);
 	};
 
-	// TODO: Random constant. For decompression/keyfinding bombs
-	while (iterCount<1048576)
+	while (!search.exhausted && !search.cancelled)
 	{
 		// this is the checkpoint. Hardly ideal, but best we can do without co-routines
 		inputOffset=uint32_t(inputStream.getOffset());
@@ -370,23 +418,92 @@ void PPDecompressor::findKeyRound(BackwardInputStream &inputStream,LSBBitReader<
 		if (failed) break;
 		outputPosition-=count;
 
-		iterCount++;
+		if (++search.iterCount==0x1000U) search.checkpoint();
 	}
-	if (failed) return;
+	if (failed || search.cancelled) return;
 	// If not all bits are resolved, that is bad
 	if (keyMask==0xffff'ffffU)
 		throw DoneException(keyBits);
 }
 
-void PPDecompressor::findKey(uint32_t keyBits,uint32_t keyMask)
+void PPDecompressor::findKey(uint32_t keyBits,uint32_t keyMask,KeySearch &search) const
 {
 	BackwardInputStream inputStream{_packedData,10,_dataStart};
 	LSBBitReader<BackwardInputStream> bitReader{inputStream};
 
 	bitReader.readBitsBE32(_startShift);
 
-	uint32_t iterCount=0;
-	findKeyRound(inputStream,bitReader,keyBits,keyMask,uint32_t(_rawSize),iterCount);
+	findKeyRound(inputStream,bitReader,keyBits,keyMask,uint32_t(_rawSize),search);
+}
+
+// candidates are pairs of known key bits and mask, tried in order
+uint32_t PPDecompressor::searchKey(const std::vector<std::pair<uint32_t,uint32_t>> &candidates)
+{
+	// The split is the same on every machine, the cutoff and the budget depend on it.
+	// Paths that skip a prefix bit are walked in all of its tasks, thus it is not too fine either
+	constexpr uint32_t prefixLength{4U};
+
+	KeySearchControl control;
+	const auto &progress{getKeySearchProgress()};
+	std::mutex mutex;
+	size_t done{0};
+	size_t total{candidates.size()<<prefixLength};
+	size_t budget{getKeySearchBudget()};
+	if (budget) budget=std::max(budget/total,size_t(1U));
+
+	for (auto [keyBits,keyMask] : candidates)
+	{
+		// first unknown bits in the order they are read
+		std::array<uint32_t,prefixLength> prefixBits;
+		uint32_t prefixCount{0};
+		for (uint32_t i=0;i<32U && prefixCount<prefixLength;i++)
+		{
+			uint32_t bitPos{(_startShift+i)&31U};
+			if (!((keyMask>>bitPos)&1U)) prefixBits[prefixCount++]=bitPos;
+		}
+
+		// either a key or running out of budget, from the lowest task that has one
+		uint32_t key{0};
+		bool overBudget{false};
+		control.foundTask=~0U;
+		Parallel::forEach(size_t(1U)<<prefixCount,[&](size_t i)
+		{
+			// TODO: Random constant. For decompression/keyfinding bombs
+			KeySearch search{control,uint32_t(i),0,0,size_t(1048576U)>>prefixCount,budget};
+			for (uint32_t j=0;j<prefixCount;j++)
+			{
+				search.fixedMask|=1U<<prefixBits[j];
+				if ((i>>(prefixCount-j-1U))&1U) search.fixedBits|=1U<<prefixBits[j];
+			}
+			auto setResult=[&](uint32_t resultKey,bool resultOverBudget)
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				if (i<control.foundTask)
+				{
+					control.foundTask=uint32_t(i);
+					key=resultKey;
+					overBudget=resultOverBudget;
+				}
+			};
+			search.checkpoint();
+			try
+			{
+				if (!search.cancelled) findKey(keyBits,keyMask,search);
+			} catch (const DoneException &e) {
+				setResult(e.getKey(),false);
+			}
+			if (search.overBudget) setResult(0,true);
+			std::lock_guard<std::mutex> lock{mutex};
+			if (progress && !control.stopped && !progress(++done,total)) control.stopped=true;
+		});
+		if (control.foundTask!=~0U)
+		{
+			if (overBudget) break;
+			return key;
+		}
+		if (control.stopped) break;
+	}
+	throw DecompressionError();
 }
 
 void PPDecompressor::decompressImpl(Buffer &rawData,bool verify)
@@ -406,22 +523,19 @@ void PPDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		keyBits&=keyMask;
 
 		// now the fuzzy
-		try {
-			if (_startShift)
-			{
-				// SP
-				uint32_t bitCount{std::min(uint32_t(_startShift),3U)};
-				uint32_t bitMask{((1U<<bitCount)-1U)<<(_startShift-bitCount)};
-				findKey(keyBits|((fillerData^(3U<<(_startShift-bitCount)))&bitMask),keyMask|bitMask);
+		std::vector<std::pair<uint32_t,uint32_t>> candidates;
+		if (_startShift)
+		{
+			// SP
+			uint32_t bitCount{std::min(uint32_t(_startShift),3U)};
+			uint32_t bitMask{((1U<<bitCount)-1U)<<(_startShift-bitCount)};
+			candidates.emplace_back(keyBits|((fillerData^(3U<<(_startShift-bitCount)))&bitMask),keyMask|bitMask);
 
-				// Size
-				findKey(keyBits|((fillerData^(rotateBits(_rawSize&7U,3U)<<(_startShift-bitCount)))&bitMask),keyMask|bitMask);
-			}
-			findKey(keyBits,keyMask);
-			throw DecompressionError();
-		} catch (const DoneException &e) {
-			key=e.getKey();
+			// Size
+			candidates.emplace_back(keyBits|((fillerData^(rotateBits(_rawSize&7U,3U)<<(_startShift-bitCount)))&bitMask),keyMask|bitMask);
 		}
+		candidates.emplace_back(keyBits,keyMask);
+		key=searchKey(candidates);
 	}
 
 	BackwardInputStream inputStream{_packedData,_isXPK?0:(_isObsfuscated?10U:8U),_dataStart};
@@ -8,6 +8,8 @@
 #include "InputStream.hpp"
 
 #include <array>
+#include <utility>
+#include <vector>
 
 namespace ancient::internal
 {
@@ -57,8 +59,12 @@ private:
 		uint32_t	_key;
 	};
 
-	void findKeyRound(BackwardInputStream &inputStream,LSBBitReader<BackwardInputStream> &bitReader,uint32_t keyBits,uint32_t keyMask,uint32_t outputPosition,uint32_t &iterCount);
-	void findKey(uint32_t keyBits,uint32_t keyMask);
+	struct KeySearchControl;
+	struct KeySearch;
+
+	void findKeyRound(BackwardInputStream &inputStream,LSBBitReader<BackwardInputStream> &bitReader,uint32_t keyBits,uint32_t keyMask,uint32_t outputPosition,KeySearch &search) const;
+	void findKey(uint32_t keyBits,uint32_t keyMask,KeySearch &search) const;
+	uint32_t searchKey(const std::vector<std::pair<uint32_t,uint32_t>> &candidates);
 
 	const Buffer		&_packedData;
 
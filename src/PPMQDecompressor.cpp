@@ -2,15 +2,16 @@
 
 #include "common/Common.hpp"
 #include "PPMQDecompressor.hpp"
-#include "RangeDecoder.hpp"
 #include "InputStream.hpp"
 #include "OutputStream.hpp"
 #include "RangeDecoder.hpp"
 #include "FrequencyTree.hpp"
 
-#include <map>
 #include <list>
 #include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace ancient::internal
 {
@@ -41,7 +42,7 @@ const std::string &PPMQDecompressor::getSubName() const noexcept
 
 void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
-	class BitReader : public RangeDecoder::BitReader
+	class BitReader
 	{
 	public:
 		BitReader(ForwardInputStream &stream) noexcept :
@@ -51,11 +52,6 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		}
 		~BitReader() noexcept=default;
 
-		uint32_t readBit() final
-		{
-			return _reader.readBitsBE32(1);
-		}
-
 		uint32_t readBits(uint32_t bitCount)
 		{
 			return _reader.readBitsBE32(bitCount);
@@ -88,7 +84,8 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		addToHistory(ch);
 	}
 
-	RangeDecoder decoder{bitReader,uint16_t(bitReader.readBits(16))};
+	using Decoder=DirectRangeDecoder<BitReader>;
+	Decoder decoder{bitReader,uint16_t(bitReader.readBits(16))};
 
 	class InclusionList
 	{
@@ -318,10 +315,87 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	};
 	// After some eye-bleach we are ready to continue
 
+	struct Context
+	{
+		Context(InclusionList &inclusionList,uint8_t ch) noexcept :
+			escapeFreq{1U},
+			nodes{inclusionList}
+		{
+			nodes.addNew(ch);
+		};
+		~Context() noexcept=default;
+
+		uint16_t			escapeFreq;
+		ShadedSparseMTFFrequencyList	nodes;
+	};
+
+	// Contexts are never removed. Thus they can be kept in a flat array
+	// and the hash table (open addressing, linear probing) needs to have only indexes
+	class ContextTable
+	{
+	public:
+		ContextTable(InclusionList &inclusionList) :
+			_inclusionList{inclusionList},
+			_slots(1U<<_slotBits)
+		{
+			// nothing needed
+		}
+		~ContextTable() noexcept=default;
+
+		Context *find(uint64_t key) noexcept
+		{
+			auto &slot{_slots[findSlot(key)]};
+			return slot.index?&_contexts[slot.index-1U]:nullptr;
+		}
+
+		// add the symbol to the context, context is created if needed
+		void add(uint64_t key,uint8_t ch)
+		{
+			auto &slot{_slots[findSlot(key)]};
+			if (slot.index)
+			{
+				_contexts[slot.index-1U].nodes.addNew(ch);
+			} else {
+				_contexts.emplace_back(_inclusionList,ch);
+				slot={key,uint32_t(_contexts.size())};
+				if (_contexts.size()*2U>_slots.size()) grow();
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			uint64_t	key;
+			uint32_t	index{0};		// 1-based, 0 for empty slot
+		};
+
+		size_t findSlot(uint64_t key) const noexcept
+		{
+			size_t mask{_slots.size()-1U};
+			size_t i{size_t((key*0x9e37'79b9'7f4a'7c15ULL)>>(64U-_slotBits))};
+			while (_slots[i].index && _slots[i].key!=key) i=(i+1U)&mask;
+			return i;
+		}
+
+		void grow()
+		{
+			std::vector<Slot> slots(_slots.size()*2U);
+			std::swap(slots,_slots);
+			_slotBits++;
+			for (auto &slot : slots)
+				if (slot.index) _slots[findSlot(slot.key)]=slot;
+		}
+
+		InclusionList				&_inclusionList;
+		uint32_t				_slotBits{12U};
+		std::vector<Slot>			_slots;
+		std::vector<Context>			_contexts;
+	};
+
 	class Model
 	{
 	public:
-		Model(RangeDecoder &decoder,InclusionList &inclusionList) noexcept :
+		Model(Decoder &decoder,InclusionList &inclusionList) noexcept :
 			_decoder{decoder},
 			_inclusionList{inclusionList}
 		{
@@ -333,7 +407,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		virtual void mark(uint8_t ch) noexcept=0;
 
 	protected:
-		RangeDecoder				&_decoder;
+		Decoder					&_decoder;
 		InclusionList				&_inclusionList;
 	};
 
@@ -342,9 +416,10 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	public:
 		using contextFunc=std::tuple<uint32_t,uint16_t,uint8_t>(*)(uint32_t,uint8_t) noexcept;
 
-		Model2(RangeDecoder &decoder,InclusionList &inclusionList,contextFunc cf) noexcept :
+		Model2(Decoder &decoder,InclusionList &inclusionList,contextFunc cf) :
 			Model{decoder,inclusionList},
-			_cf{cf}
+			_cf{cf},
+			_contexts{inclusionList}
 		{
 			for (uint32_t i=0;i<32;i++) for (uint32_t j=0;j<18;j++)
 			{
@@ -357,6 +432,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		bool decode(uint32_t history,uint8_t history5,uint8_t &ch) final
 		{
 			auto context{_cf(history,history5)};
+			uint64_t key{(uint64_t(std::get<0>(context))<<24U)|(uint64_t(std::get<1>(context))<<8U)|std::get<2>(context)};
 
 			auto scale=[&](Context &ctx,uint16_t total)
 			{
@@ -367,9 +443,9 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 				}
 			};
 
-			if (auto it=_contexts.find(context);it!=_contexts.end())
+			if (auto *found=_contexts.find(key))
 			{
-				Context &ctx{it->second};
+				Context &ctx{*found};
 				if (ctx.nodes.size()==1U)
 				{
 					auto &node{ctx.nodes.front()};
@@ -407,7 +483,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 					ctx.escapeFreq++;		// does not check scale (under the limit?)
 					_freqs[index][count]+=20U;
 					_totals[index][count]+=20U;
-					_delayedContext=context;
+					_delayedContext=key;
 					_addNewContext=true;
 					return false;
 				}
@@ -419,7 +495,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 					ctx.nodes.excludeAll();
 					ctx.escapeFreq++;
 					scale(ctx,total);
-					_delayedContext=context;
+					_delayedContext=key;
 					_addNewContext=true;
 					return false;
 				} else {
@@ -433,7 +509,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 					return true;
 				}
 			}
-			_delayedContext=context;
+			_delayedContext=key;
 			_addNewContext=true;
 			return false;
 		}
@@ -442,35 +518,16 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		{
 			if (_addNewContext)
 			{
-				if (auto it=_contexts.find(_delayedContext);it!=_contexts.end())
-				{
-					it->second.nodes.addNew(ch);
-				} else {
-					_contexts.emplace(_delayedContext,Context{_inclusionList,ch});
-				}
+				_contexts.add(_delayedContext,ch);
 				_addNewContext=false;
 			}
 		}
 
 	private:
-		struct Context
-		{
-			Context(InclusionList &inclusionList,uint8_t ch) noexcept :
-				escapeFreq{1U},
-				nodes{inclusionList}
-			{
-				nodes.addNew(ch);
-			};
-			~Context() noexcept=default;
-
-			uint16_t			escapeFreq;
-			ShadedSparseMTFFrequencyList	nodes;
-		};
-
 		contextFunc				_cf;
 		bool					_addNewContext=false;
-		std::tuple<uint32_t,uint16_t,uint8_t>	_delayedContext;
-		std::map<std::tuple<uint32_t,uint16_t,uint8_t>,Context> _contexts;
+		uint64_t				_delayedContext;
+		ContextTable				_contexts;
 		std::array<std::array<uint16_t,18>,32>	_freqs;
 		std::array<std::array<uint16_t,18>,32>	_totals;
 	};
@@ -480,9 +537,10 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	public:
 		using contextFunc=std::pair<uint32_t,uint16_t>(*)(uint32_t) noexcept;
 
-		Model1(RangeDecoder &decoder,InclusionList &inclusionList,contextFunc cf) noexcept :
+		Model1(Decoder &decoder,InclusionList &inclusionList,contextFunc cf) :
 			Model{decoder,inclusionList},
-			_cf{cf}
+			_cf{cf},
+			_contexts{inclusionList}
 		{
 			// nothing needed
 		}
@@ -491,6 +549,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		bool decode(uint32_t history,uint8_t history5,uint8_t &ch) final
 		{
 			auto context{_cf(history)};
+			uint64_t key{(uint64_t(context.first)<<16U)|context.second};
 
 			auto scale=[&](Context &ctx,uint16_t total)
 			{
@@ -501,9 +560,9 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 				}
 			};
 
-			if (auto it=_contexts.find(context);it!=_contexts.end())
+			if (auto *found=_contexts.find(key))
 			{
-				Context &ctx{it->second};
+				Context &ctx{*found};
 				uint16_t total{ctx.nodes.getTotal()};
 				uint16_t value{_decoder.decode(total+ctx.escapeFreq)};
 				if (value<ctx.escapeFreq)
@@ -512,7 +571,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 					ctx.nodes.excludeAll();
 					ctx.escapeFreq++;
 					scale(ctx,total);
-					_delayedContext=context;
+					_delayedContext=key;
 					_addNewContext=true;
 					return false;
 				} else {
@@ -526,7 +585,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 					return true;
 				}
 			}
-			_delayedContext=context;
+			_delayedContext=key;
 			_addNewContext=true;
 			return false;
 		}
@@ -535,35 +594,16 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		{
 			if (_addNewContext)
 			{
-				if (auto it=_contexts.find(_delayedContext);it!=_contexts.end())
-				{
-					it->second.nodes.addNew(ch);
-				} else {
-					_contexts.emplace(_delayedContext,Context{_inclusionList,ch});
-				}
+				_contexts.add(_delayedContext,ch);
 				_addNewContext=false;
 			}
 		}
 
 	private:
-		struct Context
-		{
-			Context(InclusionList &inclusionList,uint8_t ch) noexcept :
-				escapeFreq{1U},
-				nodes{inclusionList}
-			{
-				nodes.addNew(ch);
-			};
-			~Context() noexcept=default;
-
-			uint16_t			escapeFreq;
-			ShadedSparseMTFFrequencyList	nodes;
-		};
-
 		contextFunc				_cf;
 		bool					_addNewContext=false;
-		std::pair<uint32_t,uint16_t>		_delayedContext;
-		std::map<std::pair<uint32_t,uint16_t>,Context> _contexts;
+		uint64_t				_delayedContext;
+		ContextTable				_contexts;
 	};
 
 	// A simple arithmetic encoder (but with sparse array)
@@ -571,7 +611,7 @@ void PPMQDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 	class Model0 : public Model
 	{
 	public:
-		Model0(RangeDecoder &decoder,InclusionList &inclusionList) noexcept :
+		Model0(Decoder &decoder,InclusionList &inclusionList) noexcept :
 			Model{decoder,inclusionList},
 			_tree{inclusionList}
 		{
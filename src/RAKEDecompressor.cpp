@@ -41,6 +41,11 @@ const std::string &RAKEDecompressor::getSubName() const noexcept
 	return (_isRAKE)?nameRAKE:nameFRHT;
 }
 
+bool RAKEDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void RAKEDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	// 2 streams
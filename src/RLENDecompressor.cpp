@@ -33,6 +33,11 @@ const std::string &RLENDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool RLENDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void RLENDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,0,_packedData.size()};
@@ -203,7 +203,7 @@ void RNCDecompressor::RNCDecompressOld(Buffer &rawData,bool verify,bool rnc2)
 
 	BackwardOutputStream outputStream{rawData,0,_rawSize};
 
-	HuffmanDecoder<uint8_t> lengthDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,5> lengthDecoder
 	{
 		HuffmanCode{1,0b0000,uint8_t{0}},
 		HuffmanCode{2,0b0010,uint8_t{1}},
@@ -212,7 +212,7 @@ void RNCDecompressor::RNCDecompressOld(Buffer &rawData,bool verify,bool rnc2)
 		HuffmanCode{4,0b1111,uint8_t{4}}
 	};
 
-	HuffmanDecoder<uint8_t> distanceDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,3> distanceDecoder
 	{
 		HuffmanCode{1,0b00,uint8_t{1}},
 		HuffmanCode{2,0b10,uint8_t{0}},
@@ -356,7 +356,7 @@ void RNCDecompressor::RNC2DecompressNew(Buffer &rawData,bool verify)
 		
 	};
 
-	HuffmanDecoder<Cmd> cmdDecoder
+	static constexpr StaticHuffmanDecoder<Cmd,5> cmdDecoder
 	{
 		HuffmanCode{1,0b0000,Cmd::LIT},
 		HuffmanCode{2,0b0010,Cmd::MOV},
@@ -366,7 +366,7 @@ void RNCDecompressor::RNC2DecompressNew(Buffer &rawData,bool verify)
 	};
 
 	/* length of 9 is a marker for literals */
-	HuffmanDecoder<uint8_t> lengthDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,6> lengthDecoder
 	{
 		HuffmanCode{2,0b000,uint8_t{4}},
 		HuffmanCode{2,0b010,uint8_t{5}},
@@ -376,7 +376,7 @@ void RNCDecompressor::RNC2DecompressNew(Buffer &rawData,bool verify)
 		HuffmanCode{3,0b111,uint8_t{9}}
 	};
 	
-	HuffmanDecoder<uint8_t> distanceDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,16> distanceDecoder
 	{
 		HuffmanCode{1,0b000000,uint8_t{0}},
 		HuffmanCode{3,0b000110,uint8_t{1}},
@@ -35,6 +35,68 @@ private:
 	uint16_t			_stream;
 };
 
+// Same decoder with the bit reader as template parameter, no virtual call per bit.
+// T needs readBits(count) returning count (up to 16) bits with the first bit in the highest position.
+// Renormalization shifts in all the leading bits where low and high agree with a single read
+template<typename T>
+class DirectRangeDecoder
+{
+public:
+	DirectRangeDecoder(T &bitReader,uint16_t initialValue) noexcept :
+		_bitReader{bitReader},
+		_stream{initialValue}
+	{
+		// nothing needed
+	}
+	~DirectRangeDecoder() noexcept=default;
+
+	uint16_t decode(uint16_t length) const noexcept
+	{
+		return ((uint32_t(_stream-_low)+1)*length-1)/(uint32_t(_high-_low)+1);
+	}
+
+	void scale(uint16_t newLow,uint16_t newHigh,uint16_t newRange)
+	{
+		uint32_t range{uint32_t(_high-_low)+1U};
+		_high=(range*newHigh)/newRange+_low-1U;
+		_low=(range*newLow)/newRange+_low;
+
+		for (;;)
+		{
+			if (_high<0x8000U || _low>=0x8000U)
+			{
+				uint32_t count{leadingZeros(_low^_high)};
+				if (!count) count=1U;
+				_low=uint16_t(uint32_t(_low)<<count);
+				_high=uint16_t((uint32_t(_high)<<count)|((1U<<count)-1U));
+				_stream=uint16_t((uint32_t(_stream)<<count)|_bitReader.readBits(count));
+			} else if (_low>=0x4000U && _high<0xc000U) {
+				_low=uint16_t((_low-0x4000U)<<1);
+				_high=uint16_t(((_high-0x4000U)<<1)|1U);
+				_stream=uint16_t(((_stream-0x4000U)<<1)|_bitReader.readBits(1U));
+			} else break;
+		}
+	}
+
+private:
+	static uint32_t leadingZeros(uint16_t value) noexcept
+	{
+		if (!value) return 16U;
+		uint32_t ret{0};
+		if (!(value&0xff00U)) { ret+=8U; value<<=8U; }
+		if (!(value&0xf000U)) { ret+=4U; value<<=4U; }
+		if (!(value&0xc000U)) { ret+=2U; value<<=2U; }
+		if (!(value&0x8000U)) ret++;
+		return ret;
+	}
+
+	T				&_bitReader;
+
+	uint16_t			_low{0};
+	uint16_t			_high{0xffffU};
+	uint16_t			_stream;
+};
+
 }
 
 #endif
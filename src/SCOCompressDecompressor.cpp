@@ -67,7 +67,7 @@ void SCOCompressDecompressor::decompressImpl(Buffer &rawData,bool verify)
 		return bitReader.readBits8(1U);
 	};
 
-	AutoExpandingForwardOutputStream outputStream{rawData};
+	AutoExpandingForwardOutputStream outputStream{rawData,nullptr,0,getRawSizeHint(0)};
 
 	OptionalHuffmanDecoder<uint32_t> decoder;
 	OptionalHuffmanDecoder<uint32_t> distanceDecoder;
@@ -37,6 +37,11 @@ const std::string &SMPLDecompressor::getSubName() const noexcept
 	return name;
 }
 
+bool SMPLDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
+
 void SMPLDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
 	ForwardInputStream inputStream{_packedData,2U,_packedData.size()};
@@ -38,6 +38,11 @@ const std::string &SQSHDecompressor::getSubName() const noexcept
 	static std::string name{"XPK-SQSH: Compressor for sampled sounds"};
 	return name;
 }
+
+bool SQSHDecompressor::isChunkIndependent() const noexcept
+{
+	return true;
+}
 	
 void SQSHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)
 {
@@ -68,7 +73,7 @@ void SQSHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 
 	ForwardOutputStream outputStream{rawData,0,_rawSize};
 
-	HuffmanDecoder<uint8_t> modDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,5> modDecoder
 	{
 		HuffmanCode{1,0b0001,uint8_t{0}},
 		HuffmanCode{2,0b0000,uint8_t{1}},
@@ -77,7 +82,7 @@ void SQSHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		HuffmanCode{4,0b0111,uint8_t{4}}
 	};
 
-	HuffmanDecoder<uint8_t> lengthDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,5> lengthDecoder
 	{
 		HuffmanCode{1,0b0000,uint8_t{0}},
 		HuffmanCode{2,0b0010,uint8_t{1}},
@@ -86,7 +91,7 @@ void SQSHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 		HuffmanCode{4,0b1111,uint8_t{4}}
 	};
 
-	HuffmanDecoder<uint8_t> distanceDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,3> distanceDecoder
 	{
 		HuffmanCode{1,0b01,uint8_t{1}},
 		HuffmanCode{2,0b00,uint8_t{0}},
@@ -211,10 +216,12 @@ void SQSHDecompressor::decompressImpl(Buffer &rawData,const Buffer &previousData
 			currentSample=outputStream.copy(distance,count);
 		} else {
 			count=std::min(count,uint32_t(_rawSize-outputStream.getOffset()));
+			if (outputStream.reserve(count)<count)
+				throw Decompressor::DecompressionError();
 			for (uint32_t i=0;i<count;i++)
 			{
 				currentSample-=readSignedBits(bits);
-				outputStream.writeByte(currentSample);
+				outputStream.writeByteUnchecked(currentSample);
 			}
 			if (accum1!=31U) accum1++;
 			prevBits=bits;
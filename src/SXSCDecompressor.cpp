@@ -2,6 +2,7 @@
 
 #include "SXSCDecompressor.hpp"
 
+#include "RangeDecoder.hpp"
 #include "InputStream.hpp"
 #include "OutputStream.hpp"
 #include "DLTADecode.hpp"
@@ -19,9 +20,9 @@ SXSCDecompressor::SXSCReader::SXSCReader(ForwardInputStream &stream) :
 	// nothing needed
 }
 
-uint32_t SXSCDecompressor::SXSCReader::readBit()
+uint32_t SXSCDecompressor::SXSCReader::readBits(uint32_t count)
 {
-	return _reader.readBits8(1);
+	return _reader.readBits8(count);
 }
 
 // ---
@@ -60,7 +61,7 @@ void SXSCDecompressor::decompressASC(Buffer &rawData,ForwardInputStream &inputSt
 	bitReaderInitialValue=inputStream.readByte()<<8;
 	bitReaderInitialValue|=inputStream.readByte();
 	SXSCReader bitReader{inputStream};
-	RangeDecoder arithDecoder(bitReader,bitReaderInitialValue);
+	DirectRangeDecoder<SXSCReader> arithDecoder(bitReader,bitReaderInitialValue);
 
 	// decoder for literal, copy, end decision
 	// two thresholds -> 3 symbols, last symbol is break with size of 1
@@ -292,7 +293,7 @@ void SXSCDecompressor::decompressHSC(Buffer &rawData,ForwardInputStream &inputSt
 	bitReaderInitialValue=inputStream.readByte()<<8;
 	bitReaderInitialValue|=inputStream.readByte();
 	SXSCReader bitReader{inputStream};
-	RangeDecoder arithDecoder{bitReader,bitReaderInitialValue};
+	DirectRangeDecoder<SXSCReader> arithDecoder{bitReader,bitReaderInitialValue};
 
 	uint8_t maxContextLength{4};
 	int16_t dropCount{2500};
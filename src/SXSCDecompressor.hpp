@@ -7,7 +7,6 @@
 
 #include "XPKDecompressor.hpp"
 #include "InputStream.hpp"
-#include "RangeDecoder.hpp"
 
 namespace ancient::internal
 {
@@ -26,13 +25,13 @@ public:
 	static std::shared_ptr<XPKDecompressor> create(uint32_t hdr,uint32_t recursionLevel,const Buffer &packedData,std::shared_ptr<XPKDecompressor::State> &state,bool verify);
 
 private:
-	class SXSCReader : public RangeDecoder::BitReader
+	class SXSCReader
 	{
 	public:
 		SXSCReader(ForwardInputStream &stream);
 		~SXSCReader() noexcept=default;
 
-		uint32_t readBit() final;
+		uint32_t readBits(uint32_t count);
 
 	private:
 		MSBBitReader<ForwardInputStream>	_reader;
@@ -0,0 +1,86 @@
+/* Copyright (C) Teemu Suutari */
+
+#include <array>
+#include <new>
+#include <optional>
+#include <vector>
+
+#include "Scanner.hpp"
+#include "common/StaticBuffer.hpp"
+#include "common/WrappedVectorBuffer.hpp"
+
+namespace ancient::internal
+{
+
+void Scanner::scan(const Buffer &data,const FoundFunc &func)
+{
+	// Prefilter: one bit for each 16-bit prefix any of the signatures can start with.
+	// Only the offsets passing this are tried with the actual decompressors
+	static const std::array<uint64_t,1024> prefixMap=[]()
+	{
+		std::array<uint64_t,1024> ret{};
+		for (auto prefix : Decompressor::getSignaturePrefixes())
+			ret[prefix>>6]|=uint64_t(1U)<<(prefix&63U);
+		return ret;
+	}();
+
+	std::vector<uint8_t> raw;
+	auto decompress=[&](Decompressor &decompressor)
+	{
+		raw.resize(decompressor.getRawSize());
+		WrappedVectorBuffer rawData{raw};
+		decompressor.decompress(rawData,true);
+	};
+
+	const uint8_t *ptr{data.data()};
+	size_t size{data.size()};
+	for (size_t i=0;i+1<size;)
+	{
+		uint32_t prefix{(uint32_t(ptr[i])<<8)|ptr[i+1]};
+		if (!(prefixMap[prefix>>6]&(uint64_t(1U)<<(prefix&63U))))
+		{
+			i++;
+			continue;
+		}
+
+		// decompressor keeps a reference to the buffer
+		std::optional<ConstStaticBuffer> stream;
+		std::shared_ptr<Decompressor> found;
+		size_t foundSize{0};
+		try
+		{
+			ConstStaticBuffer candidate{ptr+i,size-i};
+			auto decompressor{Decompressor::createFromSignature(candidate,false,true)};
+			// for formats that do not encode packed size, we will get it from decompressor
+			if (!decompressor->getPackedSize())
+				decompress(*decompressor);
+			size_t packedSize{decompressor->getPackedSize()};
+
+			// final checks with the limited buffer and fresh decompressor
+			if (packedSize && packedSize<=size-i)
+			{
+				stream.emplace(ptr+i,packedSize);
+				auto finalDecompressor{Decompressor::createFromSignature(*stream,true,true)};
+				decompress(*finalDecompressor);
+				found=finalDecompressor;
+				foundSize=packedSize;
+			}
+		} catch (const Decompressor::Error&) {
+			// full steam ahead (with next offset)
+		} catch (const Buffer::Error&) {
+			// ditto
+		} catch (const std::bad_alloc&) {
+			// ditto
+		}
+
+		if (found)
+		{
+			func(i,*found);
+			i+=foundSize;
+		} else {
+			i++;
+		}
+	}
+}
+
+}
@@ -0,0 +1,33 @@
+/* Copyright (C) Teemu Suutari */
+
+#ifndef SCANNER_HPP
+#define SCANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+
+#include "Decompressor.hpp"
+
+namespace ancient::internal
+{
+
+// Finds compressed streams embedded inside a larger buffer (disk dumps etc.)
+class Scanner
+{
+public:
+	// offset of the stream and its decompressor. The decompressor has been created with the exact size
+	// of the stream and it has been successfully decompressed with verify
+	using FoundFunc = std::function<void(size_t offset,const Decompressor &decompressor)>;
+
+	Scanner()=delete;
+
+	// Only the formats with a proper signature are searched for.
+	// Found streams are skipped over i.e. they do not overlap
+	static void scan(const Buffer &data,const FoundFunc &func);
+};
+
+}
+
+#endif
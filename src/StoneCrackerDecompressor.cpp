@@ -106,6 +106,18 @@ bool StoneCrackerDecompressor::detectHeader(uint32_t hdr,uint32_t footer) noexce
 	return detectHeaderAndGeneration(hdr,dummy);
 }
 
+bool StoneCrackerDecompressor::detectSignatureHeader(uint32_t hdr,uint32_t footer) noexcept
+{
+	uint32_t generation;
+	return detectHeaderAndGeneration(hdr,generation) && generation>=3U;
+}
+
+bool StoneCrackerDecompressor::detectGuessedHeader(uint32_t hdr,uint32_t footer) noexcept
+{
+	uint32_t generation;
+	return detectHeaderAndGeneration(hdr,generation) && generation<3U;
+}
+
 std::shared_ptr<Decompressor> StoneCrackerDecompressor::create(const Buffer &packedData,bool exactSizeKnown,bool verify)
 {
 	return std::make_shared<StoneCrackerDecompressor>(packedData,exactSizeKnown,verify);
@@ -279,7 +291,7 @@ void StoneCrackerDecompressor::decompressGen1(Buffer &rawData)
 	VariableLengthCodeDecoder countVlcDecoder{3,_modes[2]+1U,-1,0,0,0,_modes[1]+1U};
 	std::array<uint8_t,7> distanceBits{0,0,0,8,9,10,uint8_t(_modes[0]+1U)};
 
-	HuffmanDecoder<uint8_t> scDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,6> scDecoder
 	{
 		HuffmanCode{2,0b000,uint8_t{0x80}},
 		HuffmanCode{3,0b010,uint8_t{0x81}},
@@ -562,7 +574,7 @@ void StoneCrackerDecompressor::decompressGen8(Buffer &rawData)
 	VariableLengthCodeDecoder countVlcDecoder{0,1,2,3,2,1,0,8,-3,2,0,5};
 	VariableLengthCodeDecoder distanceVlcDecoder{5,9,modeBits};
 
-	HuffmanDecoder<uint8_t> countDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,9> countDecoder
 	{
 		HuffmanCode{1,0b00000000,uint8_t{0x80}},
 		HuffmanCode{2,0b00000011,uint8_t{1}},
@@ -575,7 +587,7 @@ void StoneCrackerDecompressor::decompressGen8(Buffer &rawData)
 		HuffmanCode{8,0b10011111,uint8_t{0x8bU}}
 	};
 
-	HuffmanDecoder<uint8_t> distanceDecoder
+	static constexpr StaticHuffmanDecoder<uint8_t,3> distanceDecoder
 	{
 		HuffmanCode{1,0b01,uint8_t{2}},
 		HuffmanCode{2,0b00,uint8_t{1}},
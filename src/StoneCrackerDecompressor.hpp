@@ -24,6 +24,9 @@ public:
 	void decompressImpl(Buffer &rawData,bool verify) final;
 
 	static bool detectHeader(uint32_t hdr,uint32_t footer) noexcept;
+	// 3.00 onwards (and the specials) have a proper id, the older ones are only guessed
+	static bool detectSignatureHeader(uint32_t hdr,uint32_t footer) noexcept;
+	static bool detectGuessedHeader(uint32_t hdr,uint32_t footer) noexcept;
 
 	static std::shared_ptr<Decompressor> create(const Buffer &packedData,bool exactSizeKnown,bool verify);
 
@@ -125,7 +125,7 @@ void VicXDecompressor::decompressImpl(Buffer &rawData,bool verify)
 			} else outputStream.writeByte(uint8_t(code));
 		}
 	} else {
-		AutoExpandingForwardOutputStream outputStream{rawData};
+		AutoExpandingForwardOutputStream outputStream{rawData,nullptr,0,getRawSizeHint(0)};
 
 		for (;;)
 		{
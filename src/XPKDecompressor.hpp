@@ -34,6 +34,9 @@ public:
 
 	virtual const std::string &getSubName() const noexcept=0;
 
+	// true if the chunk does not need the state nor the previous chunks i.e. it can be decompressed in parallel
+	virtual bool isChunkIndependent() const noexcept { return false; }
+
 	// Actual decompression
 	virtual void decompressImpl(Buffer &rawData,const Buffer &previousData,bool verify)=0;
 
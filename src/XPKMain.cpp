@@ -7,6 +7,8 @@
 #include "common/SubBuffer.hpp"
 #include "common/OverflowCheck.hpp"
 #include "common/Common.hpp"
+#include "common/WrappedVectorBuffer.hpp"
+#include "common/Parallel.hpp"
 #include "XPKMain.hpp"
 #include "XPKDecompressor.hpp"
 
@@ -243,56 +245,177 @@ void XPKMain::decompressImpl(Buffer &rawData,bool verify)
 	if (_hasPassword)
 		throw DecompressionError();
 
+	if (!decompressParallel(rawData,verify))
+	{
+		uint32_t destOffset{0};
+		std::shared_ptr<XPKDecompressor::State> state;
+		forEachChunk([&](const Buffer &header,const Buffer &chunk,uint32_t rawChunkSize,uint8_t chunkType)->bool
+		{
+			if (OverflowCheck::sum(destOffset,rawChunkSize)>rawData.size())
+				throw DecompressionError();
+			if (!rawChunkSize) return true;
+
+			ConstSubBuffer previousBuffer{rawData,0,destOffset};
+			SubBuffer DestBuffer{rawData,destOffset,rawChunkSize};
+			if (!decompressChunk(DestBuffer,previousBuffer,chunk,chunkType,state,verify))
+				return false;
+
+			destOffset+=rawChunkSize;
+			return true;
+		});
+
+		if (destOffset!=_rawSize)
+			throw DecompressionError();
+	}
+
+	if (verify)
+	{
+		if (std::memcmp(_packedData.data()+16U,rawData.data(),std::min(_rawSize,16U)))
+			throw DecompressionError();
+	}
+}
+
+void XPKMain::decompressStreamImpl(const OutputSink &sink,bool verify)
+{
+	if (_hasPassword)
+		throw DecompressionError();
+
+	// Chunk by chunk. Only the last 64k of the previous chunks are kept for the
+	// sub-formats referencing previous data (enough for SHRX)
+	static constexpr uint32_t historySize{65536U};
+
+	std::vector<uint8_t> data;
+	WrappedVectorBuffer buffer{data};
+	uint32_t historyLength{0};
 	uint32_t destOffset{0};
+	std::array<uint8_t,16> verifyData;
 	std::shared_ptr<XPKDecompressor::State> state;
 	forEachChunk([&](const Buffer &header,const Buffer &chunk,uint32_t rawChunkSize,uint8_t chunkType)->bool
+	{
+		if (OverflowCheck::sum(destOffset,rawChunkSize)>_rawSize)
+			throw DecompressionError();
+		if (!rawChunkSize) return true;
+
+		buffer.resize(historyLength+rawChunkSize);
+		ConstSubBuffer previousBuffer{buffer,0,historyLength};
+		SubBuffer DestBuffer{buffer,historyLength,rawChunkSize};
+		if (!decompressChunk(DestBuffer,previousBuffer,chunk,chunkType,state,verify))
+			return false;
+
+		for (uint32_t i=destOffset;i<16U && i<destOffset+rawChunkSize;i++)
+			verifyData[i]=DestBuffer[i-destOffset];
+		sink(DestBuffer);
+		destOffset+=rawChunkSize;
+
+		uint32_t newHistoryLength{std::min(historyLength+rawChunkSize,historySize)};
+		std::memmove(buffer.data(),buffer.data()+historyLength+rawChunkSize-newHistoryLength,newHistoryLength);
+		historyLength=newHistoryLength;
+		return true;
+	});
+
+	if (destOffset!=_rawSize)
+		throw DecompressionError();
+
+	if (verify)
+	{
+		if (std::memcmp(_packedData.data()+16U,verifyData.data(),std::min(_rawSize,16U)))
+			throw DecompressionError();
+	}
+}
+
+bool XPKMain::decompressParallel(Buffer &rawData,bool verify) const
+{
+	if (Parallel::getWorkerCount()<2U)
+		return false;
+
+	struct ChunkInfo
+	{
+		size_t		offset;
+		size_t		size;
+		uint32_t	destOffset;
+		uint32_t	rawSize;
+		uint8_t		type;
+	};
+
+	// Scan the chunks first. Only when the sub-decompressor says it does not care about
+	// state nor the previous data we can decompress the chunks concurrently
+	std::vector<ChunkInfo> chunks;
+	uint32_t destOffset{0};
+	bool isIndependent{true};
+	bool isProbed{false};
+	forEachChunk([&](const Buffer &header,const Buffer &chunk,uint32_t rawChunkSize,uint8_t chunkType)->bool
 	{
 		if (OverflowCheck::sum(destOffset,rawChunkSize)>rawData.size())
 			throw DecompressionError();
 		if (!rawChunkSize) return true;
 
-		ConstSubBuffer previousBuffer{rawData,0,destOffset};
-		SubBuffer DestBuffer{rawData,destOffset,rawChunkSize};
-		switch (chunkType)
+		if (chunkType==1U && !isProbed)
 		{
-			case 0:
-			if (rawChunkSize!=chunk.size())
-				throw DecompressionError();;
-			std::memcpy(DestBuffer.data(),chunk.data(),rawChunkSize);
-			break;
-
-			case 1:
+			try
 			{
-				try
-				{
-					auto sub{createDecompressor(_type,_recursionLevel,chunk,state,false)};
-					sub->decompressImpl(DestBuffer,previousBuffer,verify);
-				} catch (const InvalidFormatError&) {
-					// we should throw a correct error
-					throw DecompressionError();
-				}
+				std::shared_ptr<XPKDecompressor::State> state;
+				isIndependent=createDecompressor(_type,_recursionLevel,chunk,state,false)->isChunkIndependent();
+			} catch (const Error&) {
+				// let the normal path report the error
+				isIndependent=false;
 			}
-			break;
-
-			case 15U:
-			break;
-			
-			default:
-			return false;
+			isProbed=true;
+		} else if (chunkType!=0 && chunkType!=1U && chunkType!=15U) {
+			isIndependent=false;
 		}
+		if (!isIndependent) return false;
 
+		chunks.push_back({size_t(chunk.data()-_packedData.data()),chunk.size(),destOffset,rawChunkSize,chunkType});
 		destOffset+=rawChunkSize;
 		return true;
 	});
-
+	if (!isIndependent || chunks.size()<2U)
+		return false;
 	if (destOffset!=_rawSize)
 		throw DecompressionError();
 
-	if (verify)
+	Parallel::forEach(chunks.size(),[&](size_t i)
 	{
-		if (std::memcmp(_packedData.data()+16U,rawData.data(),std::min(_rawSize,16U)))
-			throw DecompressionError();
+		const auto &it{chunks[i]};
+		ConstSubBuffer chunk{_packedData,it.offset,it.size};
+		ConstSubBuffer previousBuffer{rawData,0,0};
+		SubBuffer DestBuffer{rawData,it.destOffset,it.rawSize};
+		std::shared_ptr<XPKDecompressor::State> state;
+		decompressChunk(DestBuffer,previousBuffer,chunk,it.type,state,verify);
+	});
+	return true;
+}
+
+bool XPKMain::decompressChunk(Buffer &rawChunk,const Buffer &previousData,const Buffer &chunk,uint8_t chunkType,std::shared_ptr<XPKDecompressor::State> &state,bool verify) const
+{
+	switch (chunkType)
+	{
+		case 0:
+		if (rawChunk.size()!=chunk.size())
+			throw DecompressionError();;
+		std::memcpy(rawChunk.data(),chunk.data(),rawChunk.size());
+		break;
+
+		case 1:
+		{
+			try
+			{
+				auto sub{createDecompressor(_type,_recursionLevel,chunk,state,false)};
+				sub->decompressImpl(rawChunk,previousData,verify);
+			} catch (const InvalidFormatError&) {
+				// we should throw a correct error
+				throw DecompressionError();
+			}
+		}
+		break;
+
+		case 15U:
+		break;
+		
+		default:
+		return false;
 	}
+	return true;
 }
 
 std::shared_ptr<Decompressor> XPKMain::createDecompressor(uint32_t recursionLevel,const Buffer &buffer,bool verify)
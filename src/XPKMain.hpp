@@ -24,6 +24,7 @@ public:
 	size_t getRawSize() const noexcept final;
 
 	void decompressImpl(Buffer &rawData,bool verify) final;
+	void decompressStreamImpl(const OutputSink &sink,bool verify) final;
 
 	static bool detectHeader(uint32_t hdr,uint32_t footer) noexcept;
 
@@ -41,6 +42,9 @@ private:
 	template <typename F>
 	void forEachChunk(F func) const;
 
+	bool decompressParallel(Buffer &rawData,bool verify) const;
+	bool decompressChunk(Buffer &rawChunk,const Buffer &previousData,const Buffer &chunk,uint8_t chunkType,std::shared_ptr<XPKDecompressor::State> &state,bool verify) const;
+
 	const Buffer	&_packedData;
 
 	uint32_t	_packedSize{0};
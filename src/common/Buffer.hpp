@@ -62,17 +62,74 @@ public:
 	virtual bool isResizable() const noexcept=0;
 	virtual void resize(size_t newSize);
 
-	uint8_t &operator[](size_t i);
-	const uint8_t &operator[](size_t i) const;
+	// Accessors are inline and check the bounds against a single size() call.
+	// Decoders that access a whole range should use view() to check the range only once
+	uint8_t &operator[](size_t i)
+	{
+		if (i>=size()) throw OutOfBoundsError();
+		return data()[i];
+	}
+
+	const uint8_t &operator[](size_t i) const
+	{
+		if (i>=size()) throw OutOfBoundsError();
+		return data()[i];
+	}
 
-	uint32_t readBE32(size_t offset) const;
-	uint16_t readBE16(size_t offset) const;
+	const uint8_t *view(size_t offset,size_t length) const
+	{
+		checkRange(offset,length);
+		return data()+offset;
+	}
 
-	uint64_t readLE64(size_t offset) const;
-	uint32_t readLE32(size_t offset) const;
-	uint16_t readLE16(size_t offset) const;
+	uint8_t *view(size_t offset,size_t length)
+	{
+		checkRange(offset,length);
+		return data()+offset;
+	}
+
+	uint32_t readBE32(size_t offset) const
+	{
+		const uint8_t *ptr{view(offset,4U)};
+		return (uint32_t(ptr[0])<<24)|(uint32_t(ptr[1])<<16)|(uint32_t(ptr[2])<<8)|uint32_t(ptr[3]);
+	}
+
+	uint16_t readBE16(size_t offset) const
+	{
+		const uint8_t *ptr{view(offset,2U)};
+		return (uint16_t(ptr[0])<<8)|uint16_t(ptr[1]);
+	}
 
-	uint8_t read8(size_t offset) const;
+	uint64_t readLE64(size_t offset) const
+	{
+		const uint8_t *ptr{view(offset,8U)};
+		return (uint64_t(ptr[7])<<56)|(uint64_t(ptr[6])<<48)|(uint64_t(ptr[5])<<40)|(uint64_t(ptr[4])<<32)|
+			(uint64_t(ptr[3])<<24)|(uint64_t(ptr[2])<<16)|(uint64_t(ptr[1])<<8)|uint64_t(ptr[0]);
+	}
+
+	uint32_t readLE32(size_t offset) const
+	{
+		const uint8_t *ptr{view(offset,4U)};
+		return (uint32_t(ptr[3])<<24)|(uint32_t(ptr[2])<<16)|(uint32_t(ptr[1])<<8)|uint32_t(ptr[0]);
+	}
+
+	uint16_t readLE16(size_t offset) const
+	{
+		const uint8_t *ptr{view(offset,2U)};
+		return (uint16_t(ptr[1])<<8)|uint16_t(ptr[0]);
+	}
+
+	uint8_t read8(size_t offset) const
+	{
+		return (*this)[offset];
+	}
+
+private:
+	void checkRange(size_t offset,size_t length) const
+	{
+		size_t currentSize{size()};
+		if (offset>currentSize || length>currentSize-offset) throw OutOfBoundsError();
+	}
 };
 
 }
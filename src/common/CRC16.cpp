@@ -2,6 +2,8 @@
 
 #include <cstdint>
 
+#include <array>
+
 #include "Buffer.hpp"
 #include "OverflowCheck.hpp"
 
@@ -9,7 +11,7 @@
 namespace ancient::internal
 {
 
-static const uint16_t CRC16Table[256]={
+static constexpr uint16_t CRC16Table[256]={
 	0x0000,0xc0c1,0xc181,0x0140,0xc301,0x03c0,0x0280,0xc241,0xc601,0x06c0,0x0780,0xc741,0x0500,0xc5c1,0xc481,0x0440,
 	0xcc01,0x0cc0,0x0d80,0xcd41,0x0f00,0xcfc1,0xce81,0x0e40,0x0a00,0xcac1,0xcb81,0x0b40,0xc901,0x09c0,0x0880,0xc841,
 	0xd801,0x18c0,0x1980,0xd941,0x1b00,0xdbc1,0xda81,0x1a40,0x1e00,0xdec1,0xdf81,0x1f40,0xdd01,0x1dc0,0x1c80,0xdc41,
@@ -27,10 +29,28 @@ static const uint16_t CRC16Table[256]={
 	0x8801,0x48c0,0x4980,0x8941,0x4b00,0x8bc1,0x8a81,0x4a40,0x4e00,0x8ec1,0x8f81,0x4f40,0x8d01,0x4dc0,0x4c80,0x8c41,
 	0x4400,0x84c1,0x8581,0x4540,0x8701,0x47c0,0x4680,0x8641,0x8201,0x42c0,0x4380,0x8341,0x4100,0x81c1,0x8081,0x4040};
 
+// Tables for slicing-by-8: table n is the CRC of a byte followed by n zero bytes
+static constexpr auto CRC16Tables=[]()
+{
+	std::array<std::array<uint16_t,256>,8> ret{};
+	for (uint32_t i=0;i<256;i++) ret[0][i]=CRC16Table[i];
+	for (uint32_t j=1;j<8;j++)
+		for (uint32_t i=0;i<256;i++)
+			ret[j][i]=(ret[j-1][i]>>8)^ret[0][ret[j-1][i]&0xff];
+	return ret;
+}();
+
 uint16_t CRC16(const Buffer &buffer,size_t offset,size_t len,uint16_t accumulator)
 {
 	if (!len || OverflowCheck::sum(offset,len)>buffer.size()) throw Buffer::OutOfBoundsError();
 	const uint8_t *ptr=buffer.data()+offset;
+	const auto &t{CRC16Tables};
+	for (;len>=8;len-=8,ptr+=8)
+	{
+		uint32_t a{accumulator^(uint32_t(ptr[0])|(uint32_t(ptr[1])<<8))};
+		accumulator=t[7][a&0xff]^t[6][a>>8]^t[5][ptr[2]]^t[4][ptr[3]]^
+			t[3][ptr[4]]^t[2][ptr[5]]^t[1][ptr[6]]^t[0][ptr[7]];
+	}
 	for (size_t i=0;i<len;i++)
 		accumulator=(accumulator>>8)^CRC16Table[(accumulator&0xff)^ptr[i]];
 	return accumulator;
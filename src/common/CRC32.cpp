@@ -2,6 +2,8 @@
 
 #include <cstdint>
 
+#include <array>
+
 #include "Buffer.hpp"
 #include "OverflowCheck.hpp"
 
@@ -9,7 +11,7 @@
 namespace ancient::internal
 {
 
-static const uint32_t CRC32Table[256]={
+static constexpr uint32_t CRC32Table[256]={
 	0x00000000U,0x77073096U,0xee0e612cU,0x990951baU,0x076dc419U,0x706af48fU,0xe963a535U,0x9e6495a3U,
 	0x0edb8832U,0x79dcb8a4U,0xe0d5e91eU,0x97d2d988U,0x09b64c2bU,0x7eb17cbdU,0xe7b82d07U,0x90bf1d91U,
 	0x1db71064U,0x6ab020f2U,0xf3b97148U,0x84be41deU,0x1adad47dU,0x6ddde4ebU,0xf4d4b551U,0x83d385c7U,
@@ -43,12 +45,31 @@ static const uint32_t CRC32Table[256]={
 	0xbdbdf21cU,0xcabac28aU,0x53b39330U,0x24b4a3a6U,0xbad03605U,0xcdd70693U,0x54de5729U,0x23d967bfU,
 	0xb3667a2eU,0xc4614ab8U,0x5d681b02U,0x2a6f2b94U,0xb40bbe37U,0xc30c8ea1U,0x5a05df1bU,0x2d02ef8dU};
 
+// Tables for slicing-by-8: table n is the CRC of a byte followed by n zero bytes
+static constexpr auto CRC32Tables=[]()
+{
+	std::array<std::array<uint32_t,256>,8> ret{};
+	for (uint32_t i=0;i<256;i++) ret[0][i]=CRC32Table[i];
+	for (uint32_t j=1;j<8;j++)
+		for (uint32_t i=0;i<256;i++)
+			ret[j][i]=(ret[j-1][i]>>8)^ret[0][ret[j-1][i]&0xff];
+	return ret;
+}();
+
 uint32_t CRC32(const Buffer &buffer,size_t offset,size_t len,uint32_t accumulator)
 {
 
 	if (!len || OverflowCheck::sum(offset,len)>buffer.size()) throw Buffer::OutOfBoundsError();
 	const uint8_t *ptr=buffer.data()+offset;
+	const auto &t{CRC32Tables};
 	accumulator=~accumulator;
+	// 8 bytes at a time
+	for (;len>=8;len-=8,ptr+=8)
+	{
+		uint32_t a{accumulator^(uint32_t(ptr[0])|(uint32_t(ptr[1])<<8)|(uint32_t(ptr[2])<<16)|(uint32_t(ptr[3])<<24))};
+		accumulator=t[7][a&0xff]^t[6][(a>>8)&0xff]^t[5][(a>>16)&0xff]^t[4][a>>24]^
+			t[3][ptr[4]]^t[2][ptr[5]]^t[1][ptr[6]]^t[0][ptr[7]];
+	}
 	for (size_t i=0;i<len;i++)
 		accumulator=(accumulator>>8)^CRC32Table[(accumulator&0xff)^ptr[i]];
 	return ~accumulator;
@@ -62,7 +83,7 @@ uint32_t CRC32Byte(uint8_t ch,uint32_t accumulator) noexcept
 // instead of bit-twiddling lets have a separate implementation for reverse
 
 // same table as the previous one, but reflected
-static const uint32_t CRC32RevTable[256]={
+static constexpr uint32_t CRC32RevTable[256]={
 	0x00000000U,0x04c11db7U,0x09823b6eU,0x0d4326d9U,0x130476dcU,0x17c56b6bU,0x1a864db2U,0x1e475005U,
 	0x2608edb8U,0x22c9f00fU,0x2f8ad6d6U,0x2b4bcb61U,0x350c9b64U,0x31cd86d3U,0x3c8ea00aU,0x384fbdbdU,
 	0x4c11db70U,0x48d0c6c7U,0x4593e01eU,0x4152fda9U,0x5f15adacU,0x5bd4b01bU,0x569796c2U,0x52568b75U,
@@ -96,12 +117,29 @@ static const uint32_t CRC32RevTable[256]={
 	0x89b8fd09U,0x8d79e0beU,0x803ac667U,0x84fbdbd0U,0x9abc8bd5U,0x9e7d9662U,0x933eb0bbU,0x97ffad0cU,
 	0xafb010b1U,0xab710d06U,0xa6322bdfU,0xa2f33668U,0xbcb4666dU,0xb8757bdaU,0xb5365d03U,0xb1f740b4U};
 
+static constexpr auto CRC32RevTables=[]()
+{
+	std::array<std::array<uint32_t,256>,8> ret{};
+	for (uint32_t i=0;i<256;i++) ret[0][i]=CRC32RevTable[i];
+	for (uint32_t j=1;j<8;j++)
+		for (uint32_t i=0;i<256;i++)
+			ret[j][i]=(ret[j-1][i]<<8)^ret[0][ret[j-1][i]>>24];
+	return ret;
+}();
+
 uint32_t CRC32Rev(const Buffer &buffer,size_t offset,size_t len,uint32_t accumulator)
 {
 
 	if (!len || OverflowCheck::sum(offset,len)>buffer.size()) throw Buffer::OutOfBoundsError();
 	const uint8_t *ptr=buffer.data()+offset;
+	const auto &t{CRC32RevTables};
 	accumulator=~accumulator;
+	for (;len>=8;len-=8,ptr+=8)
+	{
+		uint32_t a{accumulator^((uint32_t(ptr[0])<<24)|(uint32_t(ptr[1])<<16)|(uint32_t(ptr[2])<<8)|uint32_t(ptr[3]))};
+		accumulator=t[7][a>>24]^t[6][(a>>16)&0xff]^t[5][(a>>8)&0xff]^t[4][a&0xff]^
+			t[3][ptr[4]]^t[2][ptr[5]]^t[1][ptr[6]]^t[0][ptr[7]];
+	}
 	for (size_t i=0;i<len;i++)
 		accumulator=(accumulator<<8)^CRC32RevTable[(accumulator>>24)^ptr[i]];
 	return ~accumulator;
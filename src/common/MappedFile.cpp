@@ -0,0 +1,113 @@
+/* Copyright (C) Teemu Suutari */
+
+#include "MappedFile.hpp"
+#include "ancient.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ancient::internal
+{
+
+MappedFile::MappedFile(const std::string &fileName)
+{
+	if (mapFile(fileName))
+		return;
+
+	// not mappable (f.e. pipe or unsupported filesystem), read it instead
+	std::ifstream file{fileName.c_str(),std::ios::in|std::ios::binary};
+	if (!file.is_open())
+		throw IOError();
+	// size is not necessarily known beforehand
+	_fallback.assign(std::istreambuf_iterator<char>{file},std::istreambuf_iterator<char>{});
+	if (file.bad())
+		throw IOError();
+	_data=_fallback.data();
+	_size=_fallback.size();
+}
+
+MappedFile::~MappedFile() noexcept
+{
+	unmapFile();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::mapFile(const std::string &fileName) noexcept
+{
+	HANDLE file{CreateFileA(fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr)};
+	if (file==INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file,&size) || !size.QuadPart || uint64_t(size.QuadPart)>uint64_t(SIZE_MAX))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping{CreateFileMappingA(file,nullptr,PAGE_READONLY,0,0,nullptr)};
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+	void *view{MapViewOfFile(mapping,FILE_MAP_READ,0,0,0)};
+	CloseHandle(mapping);
+	if (!view)
+		return false;
+	_mapping=view;
+	_data=static_cast<const uint8_t*>(view);
+	_size=size_t(size.QuadPart);
+	return true;
+}
+
+void MappedFile::unmapFile() noexcept
+{
+	if (_mapping)
+		UnmapViewOfFile(_mapping);
+	_mapping=nullptr;
+}
+
+#else
+
+bool MappedFile::mapFile(const std::string &fileName) noexcept
+{
+	int fd{::open(fileName.c_str(),O_RDONLY)};
+	if (fd<0)
+		return false;
+	struct stat st;
+	// empty files can not be mapped
+	if (::fstat(fd,&st)<0 || !S_ISREG(st.st_mode) || st.st_size<=0 || uint64_t(st.st_size)>uint64_t(SIZE_MAX))
+	{
+		::close(fd);
+		return false;
+	}
+	size_t size{size_t(st.st_size)};
+	void *mapping{::mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0)};
+	// mapping stays valid after close
+	::close(fd);
+	if (mapping==MAP_FAILED)
+		return false;
+	_mapping=mapping;
+	_data=static_cast<const uint8_t*>(mapping);
+	_size=size;
+	return true;
+}
+
+void MappedFile::unmapFile() noexcept
+{
+	if (_mapping)
+		::munmap(_mapping,_size);
+	_mapping=nullptr;
+}
+
+#endif
+
+}
@@ -0,0 +1,49 @@
+/* Copyright (C) Teemu Suutari */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ancient::internal
+{
+
+// Read-only view of a file. Memory mapped when possible so the data is paged
+// in only when it is accessed. Falls back to reading the file to memory
+class MappedFile
+{
+public:
+	MappedFile(const MappedFile&)=delete;
+	MappedFile& operator=(const MappedFile&)=delete;
+
+	// throws IOError if the file can not be read
+	MappedFile(const std::string &fileName);
+	~MappedFile() noexcept;
+
+	const uint8_t *data() const noexcept
+	{
+		return _data;
+	}
+
+	size_t size() const noexcept
+	{
+		return _size;
+	}
+
+private:
+	bool mapFile(const std::string &fileName) noexcept;
+	void unmapFile() noexcept;
+
+	const uint8_t		*_data{nullptr};
+	size_t			_size{0};
+	void			*_mapping{nullptr};
+	std::vector<uint8_t>	_fallback;
+};
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+/* Copyright (C) Teemu Suutari */
+
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace ancient::internal
+{
+
+namespace
+{
+
+// set for the threads running the work of a forEach
+thread_local bool insideWorker{false};
+
+std::atomic<uint32_t> maxThreads{0};
+
+uint32_t getThreadLimit() noexcept
+{
+	uint32_t ret{maxThreads};
+	if (!ret) ret=std::thread::hardware_concurrency();
+	return ret?ret:1U;
+}
+
+struct Job
+{
+	size_t			count;
+	void			(*call)(void*,size_t);
+	void			*context;
+
+	std::atomic<size_t>	next{0};
+	std::atomic<bool>	failed{false};
+	std::exception_ptr	error;
+	std::mutex		errorMutex;
+	uint32_t		active{0};		// threads working on the job, protected by the pool mutex
+
+	void work()
+	{
+		for (;;)
+		{
+			size_t i{next.fetch_add(1U)};
+			if (i>=count || failed) return;
+			try
+			{
+				call(context,i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock{errorMutex};
+				if (!error) error=std::current_exception();
+				failed=true;
+			}
+		}
+	}
+};
+
+class Pool
+{
+public:
+	~Pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			_stopped=true;
+		}
+		_workAvailable.notify_all();
+		for (auto &it : _threads) it.join();
+	}
+
+	void run(Job &job)
+	{
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			// pool threads are created only when needed, calling thread is the last one
+			size_t threadCount{std::min(size_t(getThreadLimit()-1U),job.count-1U)};
+			while (_threads.size()<threadCount)
+			{
+				try
+				{
+					_threads.emplace_back([this,index=uint32_t(_threads.size())]()
+					{
+						threadMain(index);
+					});
+				} catch (const std::system_error&) {
+					// no more threads, do with what we have
+					break;
+				}
+			}
+			_jobs.push_back(&job);
+			job.active++;
+		}
+		_workAvailable.notify_all();
+
+		insideWorker=true;
+		job.work();
+		insideWorker=false;
+
+		std::unique_lock<std::mutex> lock{_mutex};
+		removeJob(job);
+		job.active--;
+		_jobDone.wait(lock,[&]()
+		{
+			return !job.active;
+		});
+	}
+
+	void notify()
+	{
+		// taking the lock so that a thread about to wait can not miss it
+		std::lock_guard<std::mutex> lock{_mutex};
+		_workAvailable.notify_all();
+	}
+
+private:
+	void threadMain(uint32_t index)
+	{
+		insideWorker=true;
+		std::unique_lock<std::mutex> lock{_mutex};
+		for (;;)
+		{
+			_workAvailable.wait(lock,[&]()
+			{
+				// threads over the limit are kept idle
+				return _stopped || (!_jobs.empty() && index+1U<getThreadLimit());
+			});
+			if (_stopped) return;
+			Job &job{*_jobs.front()};
+			job.active++;
+			lock.unlock();
+			job.work();
+			lock.lock();
+			// all of it has been taken, no use for others to join
+			removeJob(job);
+			if (!--job.active) _jobDone.notify_all();
+		}
+	}
+
+	void removeJob(Job &job)
+	{
+		auto it{std::find(_jobs.begin(),_jobs.end(),&job)};
+		if (it!=_jobs.end()) _jobs.erase(it);
+	}
+
+	std::mutex			_mutex;
+	std::condition_variable		_workAvailable;
+	std::condition_variable		_jobDone;
+	std::vector<Job*>		_jobs;
+	std::vector<std::thread>	_threads;
+	bool				_stopped{false};
+};
+
+Pool &getPool()
+{
+	static Pool pool;
+	return pool;
+}
+
+}
+
+uint32_t Parallel::getWorkerCount() noexcept
+{
+	return insideWorker?1U:getThreadLimit();
+}
+
+void Parallel::setMaxThreads(uint32_t threads) noexcept
+{
+	maxThreads=threads;
+	// idle threads might be allowed to work now
+	getPool().notify();
+}
+
+void Parallel::run(size_t count,void(*call)(void*,size_t),void *context)
+{
+	Job job{count,call,context};
+	getPool().run(job);
+	if (job.error) std::rethrow_exception(job.error);
+}
+
+}
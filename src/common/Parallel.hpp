@@ -0,0 +1,46 @@
+/* Copyright (C) Teemu Suutari */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ancient::internal
+{
+
+// Work is run on a single shared pool of threads, created when first needed.
+// Calls from inside the work are run on the calling thread, thus nesting does not add threads
+class Parallel
+{
+public:
+	// Number of threads a forEach from the calling thread can use, including itself.
+	// 1 inside the work of another forEach
+	static uint32_t getWorkerCount() noexcept;
+
+	// Limits the threads used, including the calling thread. 0 for the number of cores
+	static void setMaxThreads(uint32_t maxThreads) noexcept;
+
+	// Calls func(i) for every i in [0,count) using the pool and the calling thread.
+	// Order of the calls is not defined. First exception thrown is re-thrown after all the workers are done
+	template<typename F>
+	static void forEach(size_t count,F func)
+	{
+		if (count<2U || getWorkerCount()<2U)
+		{
+			for (size_t i=0;i<count;i++) func(i);
+			return;
+		}
+		run(count,[](void *context,size_t i)
+		{
+			(*static_cast<F*>(context))(i);
+		},&func);
+	}
+
+private:
+	static void run(size_t count,void(*call)(void*,size_t),void *context);
+};
+
+}
+
+#endif
@@ -33,4 +33,31 @@ bool ConstStaticBuffer::isResizable() const noexcept
 	return false;
 }
 
+MutableStaticBuffer::MutableStaticBuffer(uint8_t *data,size_t length) noexcept :
+	_data{data},
+	_length{length}
+{
+	// nothing needed
+}
+
+const uint8_t *MutableStaticBuffer::data() const noexcept
+{
+	return _data;
+}
+
+uint8_t *MutableStaticBuffer::data()
+{
+	return _data;
+}
+
+size_t MutableStaticBuffer::size() const noexcept
+{
+	return _length;
+}
+
+bool MutableStaticBuffer::isResizable() const noexcept
+{
+	return false;
+}
+
 }
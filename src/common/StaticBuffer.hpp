@@ -66,6 +66,27 @@ private:
 	size_t		_length;
 };
 
+
+class MutableStaticBuffer : public Buffer
+{
+public:
+	MutableStaticBuffer(const MutableStaticBuffer&)=delete;
+	MutableStaticBuffer& operator=(const MutableStaticBuffer&)=delete;
+
+	MutableStaticBuffer(uint8_t *data,size_t length) noexcept;
+	~MutableStaticBuffer() noexcept=default;
+
+	const uint8_t *data() const noexcept final;
+	uint8_t *data() final;
+
+	size_t size() const noexcept final;
+	bool isResizable() const noexcept final;
+
+private:
+	uint8_t 	*_data;
+	size_t		_length;
+};
+
 }
 
 #endif
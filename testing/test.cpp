@@ -90,6 +90,59 @@ void verifyFile(const char *packedFile,const std::vector<uint8_t> &verify,bool i
 			exit(1);
 		}
 	}
+
+	// streaming decompression should give the same result
+	std::vector<uint8_t> streamed;
+	try
+	{
+		decompressor->decompress(true,[&](const uint8_t *data,size_t size)
+		{
+			streamed.insert(streamed.end(),data,data+size);
+		});
+	} catch (const ancient::Error&)
+	{
+		fprintf(stderr,"Streaming decompression failed for %s\n",packedFile);
+		exit(1);
+	}
+	if (streamed!=raw)
+	{
+		fprintf(stderr,"Verify failed for %s - streamed data differs\n",packedFile);
+		exit(1);
+	}
+
+	// and so should decompression into caller provided buffer
+	std::vector<uint8_t> external(raw.size()+16);
+	size_t externalSize=0;
+	try
+	{
+		externalSize=decompressor->decompress(external.data(),external.size(),true);
+	} catch (const ancient::Error&)
+	{
+		fprintf(stderr,"Decompression into buffer failed for %s\n",packedFile);
+		exit(1);
+	}
+	external.resize(externalSize);
+	if (external!=raw)
+	{
+		fprintf(stderr,"Verify failed for %s - data decompressed into buffer differs\n",packedFile);
+		exit(1);
+	}
+
+	// and when reading directly from the (mapped) file, with an inexact raw size hint
+	try
+	{
+		ancient::Decompressor fileDecompressor{std::string(packedFile),true,true};
+		fileDecompressor.setRawSizeHint(raw.size()/2U+1U);
+		if (fileDecompressor.decompress(true)!=raw)
+		{
+			fprintf(stderr,"Verify failed for %s - data decompressed from file differs\n",packedFile);
+			exit(1);
+		}
+	} catch (const ancient::Error&)
+	{
+		fprintf(stderr,"Decompression from file failed for %s\n",packedFile);
+		exit(1);
+	}
 }
 
 void verifyFile(const char *packedFile,const char *rawFile,bool ignoreExpansion=false)
@@ -98,6 +151,156 @@ void verifyFile(const char *packedFile,const char *rawFile,bool ignoreExpansion=
 	verifyFile(packedFile,*verify,ignoreExpansion);
 }
 
+// obsfuscated files should report progress while searching for the key
+void verifyKeySearchProgress(const char *packedFile,const char *rawFile)
+{
+	auto packed{readFile(packedFile)};
+	auto verify{readFile(rawFile)};
+	size_t calls=0;
+	bool inRange=true;
+	try
+	{
+		ancient::Decompressor decompressor{*packed,true,true};
+		decompressor.setKeySearchProgress([&](size_t done,size_t total)->bool
+		{
+			calls++;
+			if (!done || done>total) inRange=false;
+			return true;
+		});
+		if (decompressor.decompress(true)!=*verify)
+		{
+			fprintf(stderr,"Verify failed for %s - data differs with key search progress\n",packedFile);
+			exit(1);
+		}
+	} catch (const ancient::Error&)
+	{
+		fprintf(stderr,"Decompression with key search progress failed for %s\n",packedFile);
+		exit(1);
+	}
+	if (!calls || !inRange)
+	{
+		fprintf(stderr,"Key search progress not reported properly for %s\n",packedFile);
+		exit(1);
+	}
+}
+
+// key search should stop when the budget runs out and succeed when it does not
+void verifyKeySearchBudget(const char *packedFile,const char *rawFile)
+{
+	auto packed{readFile(packedFile)};
+	auto verify{readFile(rawFile)};
+	try
+	{
+		ancient::Decompressor decompressor{*packed,true,true};
+		decompressor.setKeySearchBudget(1U);
+		decompressor.decompress(true);
+		fprintf(stderr,"Key search budget not honored for %s\n",packedFile);
+		exit(1);
+	} catch (const ancient::Error&)
+	{
+		// expected
+	}
+	try
+	{
+		ancient::Decompressor decompressor{*packed,true,true};
+		decompressor.setKeySearchBudget(size_t(1U)<<30U);
+		if (decompressor.decompress(true)!=*verify)
+		{
+			fprintf(stderr,"Verify failed for %s - data differs with key search budget\n",packedFile);
+			exit(1);
+		}
+	} catch (const ancient::Error&)
+	{
+		fprintf(stderr,"Decompression with key search budget failed for %s\n",packedFile);
+		exit(1);
+	}
+}
+
+// key search should end the same way no matter how many threads there are
+void verifyKeySearchThreads(const char *packedFile,const char *rawFile)
+{
+	auto packed{readFile(packedFile)};
+	auto verify{readFile(rawFile)};
+	for (size_t budget : {size_t(0),size_t(1U)<<20U,size_t(1U)<<21U})
+	{
+		std::optional<std::vector<uint8_t>> results[2];
+		uint32_t threads[2]={1U,16U};
+		for (uint32_t i=0;i<2U;i++)
+		{
+			ancient::Decompressor::setMaxThreads(threads[i]);
+			try
+			{
+				ancient::Decompressor decompressor{*packed,true,true};
+				decompressor.setKeySearchBudget(budget);
+				results[i]=decompressor.decompress(true);
+			} catch (const ancient::Error&)
+			{
+				// compared below
+			}
+		}
+		ancient::Decompressor::setMaxThreads(0);
+		if (results[0]!=results[1] || (!budget && results[0]!=*verify))
+		{
+			fprintf(stderr,"Key search for %s with budget %zu depends on the number of threads\n",packedFile,budget);
+			exit(1);
+		}
+	}
+}
+
+// a signature alone should be detected, since nothing is constructed for it
+void verifyDetect()
+{
+	static const char *signatures[]={"BZh9","\xff\x1f\x00\x00","\x1f\x9d\x90\x00","CrM!","\x1f\x8b\x08\x00",
+		"DMS!","\x1f\x9f\x00\x00","ICE!","IMP!","LZH!","\001LOB","ziRC","\x1f\x1e\x00\x00","SFHD","PP20",
+		"RNC\001","\x1f\xa0\x00\x00","S310","TPWM","Vice","XPKF"};
+	for (auto signature : signatures)
+	{
+		std::vector<uint8_t> packed(signature,signature+4);
+		packed.resize(8);
+		if (!ancient::Decompressor::detect(packed))
+		{
+			fprintf(stderr,"Detect failed for signature %02x%02x%02x%02x\n",packed[0],packed[1],packed[2],packed[3]);
+			exit(1);
+		}
+	}
+
+	const char junk[]="This is not a compressed file, just some text";
+	if (ancient::Decompressor::detect(reinterpret_cast<const uint8_t*>(junk),sizeof(junk)))
+	{
+		fprintf(stderr,"Junk detected as a compressed file\n");
+		exit(1);
+	}
+}
+
+// streams embedded between junk should be found at their exact positions
+void verifyScan(const std::vector<std::string> &packedFiles)
+{
+	std::vector<uint8_t> dump(100);
+	std::vector<std::pair<size_t,size_t>> expected;
+	for (auto &it : packedFiles)
+	{
+		auto packed{readFile(it)};
+		expected.emplace_back(dump.size(),packed->size());
+		dump.insert(dump.end(),packed->begin(),packed->end());
+		dump.resize(dump.size()+100);
+	}
+
+	auto hits{ancient::Scanner::scan(dump.data(),dump.size())};
+	if (hits.size()!=expected.size())
+	{
+		fprintf(stderr,"Scan failed - found %zu streams instead of %zu\n",hits.size(),expected.size());
+		exit(1);
+	}
+	for (size_t i=0;i<hits.size();i++)
+	{
+		if (hits[i].offset!=expected[i].first || hits[i].packedSize!=expected[i].second)
+		{
+			fprintf(stderr,"Scan failed for %s - found at %zu size %zu\n",packedFiles[i].c_str(),hits[i].offset,hits[i].packedSize);
+			exit(1);
+		}
+	}
+}
+
 #define BASE_DIR "testing/test_files/"
 
 int main(int argc,char **argv)
@@ -245,6 +448,9 @@ int main(int argc,char **argv)
 	verifyFile(BASE_DIR "test_C1_px20.pp",BASE_DIR "test_C1.raw");
 	verifyFile(BASE_DIR "test_C1_px20_b.pp",BASE_DIR "test_C1.raw");
 	verifyFile(BASE_DIR "test_C1_px20_c.pp",BASE_DIR "test_C1.raw");
+	verifyKeySearchProgress(BASE_DIR "test_C1_px20.pp",BASE_DIR "test_C1.raw");
+	verifyKeySearchBudget(BASE_DIR "test_C1_px20.pp",BASE_DIR "test_C1.raw");
+	verifyKeySearchThreads(BASE_DIR "test_C1_px20.pp",BASE_DIR "test_C1.raw");
 	verifyFile(BASE_DIR "test_C1_chfc.pp",BASE_DIR "test_C1.raw");
 	verifyFile(BASE_DIR "test_C1_den.pp",BASE_DIR "test_C1.raw");
 	verifyFile(BASE_DIR "test_C1_dxs9.pp",BASE_DIR "test_C1.raw");
@@ -360,5 +566,9 @@ int main(int argc,char **argv)
 	verifyFile(BASE_DIR "test_C1_tdcs.xpkf",BASE_DIR "test_C1.raw");
 	verifyFile(BASE_DIR "test_C1_zeno.xpkf",BASE_DIR "test_C1.raw");
 
+	// Scanner
+	verifyDetect();
+	verifyScan({BASE_DIR "test_C1.bz2",BASE_DIR "test_C1.gz",BASE_DIR "test_C1.crm",BASE_DIR "test_C1.imp",BASE_DIR "test_C1_nuke.xpkf",BASE_DIR "test_C1_medium.dms",BASE_DIR "test_C1.pack300_0",BASE_DIR "test_C1_zulu.sc403"});
+
 	return 0;
 }